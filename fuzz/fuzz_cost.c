@@ -0,0 +1,201 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The complexity fuzzing cost accounting
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fuzz_cost.h"
+
+#define COST_BUCKETS            32
+#define SIZE_BUCKETS            24
+#define CALIBRATION_RUNS        16
+#define DEFAULT_SLOW_NS_PER_BYTE 20000
+#define DEFAULT_SLOW_MIN_SIZE   256
+
+/* The cost levels reached so far for each input size level. libFuzzer treats
+   the extra counters as the coverage, so the inputs reaching the new cost level
+   for their size are kept in the corpus and the fuzzer climbs to the more
+   expensive inputs (the larger inputs register as new too) */
+#ifdef __clang__
+__attribute__((section("__libfuzzer_extra_counters")))
+#endif
+static uint8_t cost_counters[2][SIZE_BUCKETS][COST_BUCKETS];
+
+static unsigned long allocs = 0;
+static unsigned long long cpu_start = 0;
+static unsigned long long last_cpu_ns = 0;
+static unsigned long last_allocs = 0;
+static unsigned long long fixed_cpu_ns = 0;  /* the fixed cost of the target call */
+static unsigned long fixed_allocs = 0;
+static char calibrating = 0;
+
+void* fuzz_malloc(size_t size)
+{
+	allocs++;
+	return malloc(size);
+}
+
+void* fuzz_realloc(void* ptr, size_t size)
+{
+	allocs++;
+	return realloc(ptr, size);
+}
+
+static unsigned long long cpu_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static size_t log2_bucket(unsigned long long value, size_t buckets)
+{
+	size_t bucket = 0;
+	while (value > 1 && bucket < buckets - 1) {
+		value >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static void save_slow_input(const uint8_t* data, size_t size, unsigned long long ns_per_byte)
+{
+	const char* dir = getenv("URSULA_FUZZ_SLOW_DIR");
+	char path[4096];
+	FILE* f;
+	if (!dir) {
+		return;
+	}
+	snprintf(path, sizeof(path), "%s/slow-%llu-%lu-%lu%s", dir, ns_per_byte, size, last_allocs, fuzz_input_suffix);
+	f = fopen(path, "wb");
+	if (f) {
+		fwrite(data, 1, size, f);
+		fclose(f);
+	}
+}
+
+void fuzz_cost_begin(void)
+{
+	allocs = 0;
+	cpu_start = cpu_ns();
+}
+
+void fuzz_cost_end(const uint8_t* data, size_t size)
+{
+	const char* threshold_str = getenv("URSULA_FUZZ_SLOW_NS_PER_BYTE");
+	const char* min_size_str = getenv("URSULA_FUZZ_SLOW_MIN_SIZE");
+	unsigned long long threshold = threshold_str ? strtoull(threshold_str, NULL, 10) : DEFAULT_SLOW_NS_PER_BYTE;
+	size_t min_size = min_size_str ? strtoul(min_size_str, NULL, 10) : DEFAULT_SLOW_MIN_SIZE;
+	unsigned long long ns = cpu_ns() - cpu_start, ns_per_byte;
+	size_t size_bucket;
+
+	if (calibrating) {
+		last_cpu_ns = ns;
+		last_allocs = allocs;
+		return;
+	}
+
+	/* the fixed cost of the call would dominate the cost of the small inputs */
+	last_cpu_ns = ns > fixed_cpu_ns ? ns - fixed_cpu_ns : 0;
+	last_allocs = allocs > fixed_allocs ? allocs - fixed_allocs : 0;
+	ns_per_byte = last_cpu_ns / (size + 1);
+
+	/* the time is noisy, the allocations are exact: count them in 1/16 per byte */
+	size_bucket = log2_bucket(size + 1, SIZE_BUCKETS);
+	cost_counters[0][size_bucket][log2_bucket(ns_per_byte, COST_BUCKETS)] = 1;
+	cost_counters[1][size_bucket][log2_bucket(last_allocs * 16 / (size + 1), COST_BUCKETS)] = 1;
+
+	if (ns_per_byte > threshold && size >= min_size) {
+		save_slow_input(data, size, ns_per_byte);
+	}
+}
+
+void fuzz_cost_calibrate(void)
+{
+	size_t i;
+	fixed_cpu_ns = ~0ULL;
+	fixed_allocs = ~0UL;
+	calibrating = 1;
+	for (i = 0; i < CALIBRATION_RUNS; i++) {
+		LLVMFuzzerTestOneInput((const uint8_t*)"", 0);
+		if (last_cpu_ns < fixed_cpu_ns) fixed_cpu_ns = last_cpu_ns;
+		if (last_allocs < fixed_allocs) fixed_allocs = last_allocs;
+	}
+	calibrating = 0;
+	last_cpu_ns = 0;
+	last_allocs = 0;
+}
+
+void fuzz_cost_last(unsigned long long* ns, unsigned long* a)
+{
+	*ns = last_cpu_ns;
+	*a = last_allocs;
+}
+
+#ifdef URSULA_FUZZ_STANDALONE
+
+/* Run the fuzz target on the input files and print their cost per byte (the
+   minimized slow inputs scoring without libFuzzer) */
+int main(int argc, char** argv)
+{
+	int i;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <input-file> ...\n", argv[0]);
+		fprintf(stderr, "\n");
+		return 99;
+	}
+
+	LLVMFuzzerInitialize(&argc, &argv);
+
+	printf("Fixed cost per call: %llu ns, %lu allocs (not included)\n", fixed_cpu_ns, fixed_allocs);
+	printf("%-40s %10s %14s %10s %10s %12s\n", "input", "bytes", "cpu ns", "ns/byte", "allocs", "allocs/byte");
+	for (i = 1; i < argc; i++) {
+		FILE* f = fopen(argv[i], "rb");
+		uint8_t* data;
+		long size;
+		unsigned long long ns;
+		unsigned long a;
+
+		if (!f) {
+			fprintf(stderr, "Cannot open input file %s\n", argv[i]);
+			continue;
+		}
+		fseek(f, 0, SEEK_END);
+		size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		data = (uint8_t*)malloc(size > 0 ? size : 1);
+		size = fread(data, 1, size, f);
+		fclose(f);
+
+		LLVMFuzzerTestOneInput(data, size);
+		fuzz_cost_last(&ns, &a);
+		printf("%-40s %10ld %14llu %10.1f %10lu %12.3f\n",
+			   argv[i], size, ns, (double)ns / (size + 1), a, (double)a / (size + 1));
+		free(data);
+	}
+
+	return 0;
+}
+
+#endif
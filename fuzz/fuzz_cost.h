@@ -0,0 +1,56 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The complexity fuzzing cost accounting
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#ifndef __URSULA_FUZZ_COST_H
+#define __URSULA_FUZZ_COST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The counting allocators, the library code is compiled with malloc/realloc
+   replaced by them */
+void* fuzz_malloc(size_t size);
+void* fuzz_realloc(void* ptr, size_t size);
+
+/* Start measuring the input cost */
+void fuzz_cost_begin(void);
+
+/* Finish measuring the input cost: report the cost per input byte (without the
+   fixed cost of the call) to the fuzzer and save the input if it is slow
+   (URSULA_FUZZ_SLOW_DIR, URSULA_FUZZ_SLOW_NS_PER_BYTE and URSULA_FUZZ_SLOW_MIN_SIZE
+   environment variables) */
+void fuzz_cost_end(const uint8_t* data, size_t size);
+
+/* Measure the fixed cost of the target call on the empty input, the target
+   calls it at the end of LLVMFuzzerInitialize */
+void fuzz_cost_calibrate(void);
+
+/* The suffix of the saved slow input files, defined by the fuzz target */
+extern const char* fuzz_input_suffix;
+
+/* The cost of the last input (without the fixed cost of the call) */
+void fuzz_cost_last(unsigned long long* cpu_ns, unsigned long* allocs);
+
+/* The fuzz target */
+int LLVMFuzzerInitialize(int* argc, char*** argv);
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+#endif
@@ -0,0 +1,123 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The log checker complexity fuzz target
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fuzz_cost.h"
+
+/* count the library allocations */
+#define malloc  fuzz_malloc
+#define realloc fuzz_realloc
+#include "ursulalogcheck.c"
+#undef malloc
+#undef realloc
+
+#define FUZZ_TASK_ID "fuzz"
+
+/* The task using all condition types, the AND operand, base objects and
+   object requirements, the bench checks the saved slow logs with it too */
+#ifndef URSULA_FUZZ_TASK_FILE
+#define URSULA_FUZZ_TASK_FILE "corpus/task/task.csv"
+#endif
+
+/* the saved slow logs are read by the bench from the directory (see fuzz.cfg.in) */
+const char* fuzz_input_suffix = ".log";
+
+static UrsulaLogCheckerData* checker = NULL;
+
+static int write_file(const char* path, const char* content)
+{
+	FILE* f = fopen(path, "w");
+	if (!f) {
+		return -1;
+	}
+	fputs(content, f);
+	fclose(f);
+	return 0;
+}
+
+int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+	char dir[] = "/tmp/ursulafuzzXXXXXX";
+	char cfg_path[sizeof(dir) + 16], cfg[sizeof(URSULA_FUZZ_TASK_FILE) + 64];
+
+	(void)argc;
+	(void)argv;
+
+	if (!mkdtemp(dir)) {
+		abort();
+	}
+	snprintf(cfg_path, sizeof(cfg_path), "%s/fuzz.cfg", dir);
+	snprintf(cfg, sizeof(cfg), "%s%c%s\n%s%c%s\n",
+			 SECRET_STRING, DELIMITER, "fuzz", FUZZ_TASK_ID, DELIMITER, URSULA_FUZZ_TASK_FILE);
+	if (write_file(cfg_path, cfg) != 0 ||
+		cyberiada_ursula_log_checker_init(&checker, cfg_path) != URSULA_CHECK_NO_ERROR) {
+		abort();
+	}
+	unlink(cfg_path);
+	rmdir(dir);
+	fuzz_cost_calibrate();
+	return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	UrsulaLogCheckerResult result = 0, session_result = 0;
+	UrsulaLogSession* session = NULL;
+	char *result_code = NULL, *session_code = NULL;
+	int res, session_res;
+
+	fuzz_cost_begin();
+
+	/* the whole log */
+	res = cyberiada_ursula_log_checker_check_buffer(checker, FUZZ_TASK_ID, 1,
+													(const char*)data, size, &result, &result_code);
+
+	/* the same log fed as the live session */
+	if (cyberiada_ursula_log_session_new(checker, FUZZ_TASK_ID, &session) == URSULA_CHECK_NO_ERROR) {
+		cyberiada_ursula_log_session_feed(session, (const char*)data, size);
+		session_res = cyberiada_ursula_log_session_finish(session);
+		if (session_res == URSULA_CHECK_NO_ERROR) {
+			session_res = cyberiada_ursula_log_session_result(session, 1, &session_result, &session_code);
+		}
+		cyberiada_ursula_log_session_free(session);
+
+		/* the session should get the check result (the session limits the line length) */
+		if (size <= MAX_SESSION_LINE_LEN &&
+			((res == URSULA_CHECK_NO_ERROR) != (session_res == URSULA_CHECK_NO_ERROR) ||
+			 (res == URSULA_CHECK_NO_ERROR &&
+			  (result != session_result || !result_code || !session_code ||
+			   strcmp(result_code, session_code) != 0)))) {
+			fprintf(stderr, "The session result %d (%d) differs from the check result %d (%d)\n",
+					session_result, session_res, result, res);
+			abort();
+		}
+	}
+
+	if (result_code) free(result_code);
+	if (session_code) free(session_code);
+
+	fuzz_cost_end(data, size);
+	return 0;
+}
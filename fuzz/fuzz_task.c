@@ -0,0 +1,62 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The task config (CSV) parser complexity fuzz target
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fuzz_cost.h"
+
+/* count the library allocations */
+#define malloc  fuzz_malloc
+#define realloc fuzz_realloc
+#include "ursulalogcheck.c"
+#undef malloc
+#undef realloc
+
+const char* fuzz_input_suffix = ".csv";
+
+int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+	(void)argc;
+	(void)argv;
+	fuzz_cost_calibrate();
+	return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	UrsulaCheckerTask* task = NULL;
+	FILE* cfg;
+
+	fuzz_cost_begin();
+
+	cfg = fmemopen((void*)(size ? (const char*)data : ""), size, "r");
+	if (cfg) {
+		if (cyberiada_ursula_log_task_config_file(cfg, "<fuzz>", &task, "fuzz") == URSULA_CHECK_NO_ERROR) {
+			cyberiada_ursula_log_index_task(task);
+			cyberiada_ursula_log_destroy_tasks(task);
+		}
+	}
+
+	fuzz_cost_end(data, size);
+	return 0;
+}
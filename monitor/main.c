@@ -0,0 +1,765 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The live session monitor program
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <sys/time.h>
+
+#include "ursulalogcheck.h"
+
+/* -----------------------------------------------------------------------------
+ * The monitor constants
+ * ----------------------------------------------------------------------------- */
+
+#define DEFAULT_THREADS        4
+#define DEFAULT_IDLE_TIMEOUT   300         /* seconds */
+#define DEFAULT_REPORT_PERIOD  60          /* seconds */
+#define WHEEL_SLOTS            64          /* the timer wheel size (1 second ticks) */
+#define MAX_EVENTS             64
+#define READ_BUFFER_SIZE       16384
+#define MAX_HEADER_LEN         256
+#define DELIMITER              ':'
+#define CAPTURE_FILE           "capture.csv"
+#define MAX_PATH_LEN           4096
+
+/* -----------------------------------------------------------------------------
+ * The monitor structures
+ * ----------------------------------------------------------------------------- */
+
+typedef enum {
+	hListen = 0,                            /* the push streams listening socket */
+	hInotify,                               /* the followed files notifications */
+	hTimer,                                 /* the timer wheel ticks */
+	hSession                                /* the session file or stream */
+} HandleType;
+
+typedef struct {
+	HandleType type;
+} Handle;
+
+typedef struct _Session {
+	Handle            handle;               /* should be the first member */
+	UrsulaLogSession* log;                  /* the library session (NULL before the stream header) */
+	char*             name;                 /* the file path or the stream peer */
+	char              task_id[MAX_HEADER_LEN]; /* the task from the config or the stream header */
+	size_t            header_len;           /* the stream header bytes read so far */
+	int               salt;
+	int               fd;                   /* the file or the socket */
+	int               wd;                   /* the inotify watch (files only, -1 for streams) */
+	struct _Session*  watch_next;           /* the sessions following the same file (the same watch) */
+	char              stream;               /* the session is a push stream */
+	int               capture_fd;           /* the captured stream log (-1 if none) */
+	char              captured;             /* the followed file is in the capture records */
+	unsigned long     last_active;          /* the last activity tick */
+	struct _Session*  wheel_prev;           /* the timer wheel slot list */
+	struct _Session*  wheel_next;
+	size_t            wheel_slot;
+	char              closed;               /* the session is closed, but not freed yet */
+	struct _Session*  closed_next;          /* the closed sessions list */
+} Session;
+
+typedef struct {
+	pthread_t             thread;
+	size_t                n;
+	UrsulaLogCheckerData* checker;          /* shared between the workers */
+	int                   epoll_fd;
+	int                   inotify_fd;
+	int                   timer_fd;
+	int                   listen_fd;        /* shared between the workers, -1 if none */
+	Handle                listen_handle;
+	Handle                inotify_handle;
+	Handle                timer_handle;
+	Session*              wheel[WHEEL_SLOTS]; /* the idle sessions timer wheel */
+	Session**             watches;          /* the session lists by the inotify watch descriptor */
+	size_t                watches_size;
+	unsigned long         tick;             /* the current timer wheel tick */
+	size_t                sessions;         /* the number of the active sessions */
+	Session*              closed;           /* the sessions closed during the events batch */
+} Worker;
+
+static volatile sig_atomic_t stop = 0;
+static unsigned long idle_timeout = DEFAULT_IDLE_TIMEOUT;
+static unsigned long report_period = DEFAULT_REPORT_PERIOD;
+static const char* capture_dir = NULL;     /* the job stream capture directory */
+static int capture_fd = -1;                 /* the capture records file */
+static unsigned long long capture_start = 0; /* the capture start time (the log names prefix) */
+static unsigned long capture_seq = 0;       /* the captured streams counter */
+
+/* -----------------------------------------------------------------------------
+ * The job stream capture
+ * ----------------------------------------------------------------------------- */
+
+static unsigned long long now_ms(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+/* Record the job: arrival-time-ms:task-id:salt:log-file */
+static void capture_record(const char* task_id, int salt, const char* path)
+{
+	char record[MAX_PATH_LEN + MAX_HEADER_LEN + 64];
+	int len;
+	if (capture_fd < 0) {
+		return;
+	}
+	len = snprintf(record, sizeof(record), "%llu%c%s%c%d%c%s\n",
+				   now_ms(), DELIMITER, task_id, DELIMITER, salt, DELIMITER, path);
+	if (len > 0 && (size_t)len < sizeof(record)) {
+		/* the single append write is not interleaved with the other workers */
+		if (write(capture_fd, record, len) != len) {
+			fprintf(stderr, "Cannot write the capture record\n");
+		}
+	}
+}
+
+/* Start capturing the push stream log, returns the log file descriptor or -1 */
+static int capture_stream(const char* task_id, int salt)
+{
+	char path[MAX_PATH_LEN];
+	int fd;
+	if (capture_fd < 0) {
+		return -1;
+	}
+	/* the logs of the previous monitor runs may be referenced by the capture records,
+	   so the names are unique between the runs and the existing files are kept */
+	snprintf(path, sizeof(path), "%s/%llu-%d-%lu.log", capture_dir, capture_start, (int)getpid(),
+			 __sync_fetch_and_add(&capture_seq, 1));
+	fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Cannot create the capture log %s\n", path);
+		return -1;
+	}
+	capture_record(task_id, salt, path);
+	return fd;
+}
+
+static int capture_open(void)
+{
+	char path[MAX_PATH_LEN];
+	snprintf(path, sizeof(path), "%s/%s", capture_dir, CAPTURE_FILE);
+	capture_start = now_ms();
+	capture_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	return capture_fd;
+}
+
+/* -----------------------------------------------------------------------------
+ * The timer wheel
+ * ----------------------------------------------------------------------------- */
+
+static void wheel_insert(Worker* w, Session* s, unsigned long expires)
+{
+	s->wheel_slot = expires % WHEEL_SLOTS;
+	s->wheel_prev = NULL;
+	s->wheel_next = w->wheel[s->wheel_slot];
+	if (s->wheel_next) s->wheel_next->wheel_prev = s;
+	w->wheel[s->wheel_slot] = s;
+}
+
+static void wheel_remove(Worker* w, Session* s)
+{
+	if (s->wheel_prev) {
+		s->wheel_prev->wheel_next = s->wheel_next;
+	} else {
+		w->wheel[s->wheel_slot] = s->wheel_next;
+	}
+	if (s->wheel_next) s->wheel_next->wheel_prev = s->wheel_prev;
+	s->wheel_prev = s->wheel_next = NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * The sessions
+ * ----------------------------------------------------------------------------- */
+
+static size_t session_memory(Session* s)
+{
+	return sizeof(Session) + strlen(s->name) + 1 + cyberiada_ursula_log_session_memory(s->log);
+}
+
+static void session_report(Session* s, const char* reason)
+{
+	UrsulaLogCheckerResult result = URSULA_CHECK_RESULT_ERROR;
+	char* result_code = NULL;
+
+	if (s->log) {
+		cyberiada_ursula_log_session_result(s->log, s->salt, &result, &result_code);
+	}
+	printf("%s%c%s%c%d%c%d%c%s%c%s%c%lu\n",
+		   s->name, DELIMITER,
+		   s->task_id, DELIMITER,
+		   s->salt, DELIMITER,
+		   result, DELIMITER,
+		   result_code ? result_code : "", DELIMITER,
+		   reason, DELIMITER,
+		   session_memory(s));
+	fflush(stdout);
+	if (result_code) free(result_code);
+}
+
+static Session* session_new(Worker* w, const char* name, int fd, char stream)
+{
+	Session* s = (Session*)malloc(sizeof(Session));
+	struct epoll_event ev;
+
+	memset(s, 0, sizeof(Session));
+	s->handle.type = hSession;
+	s->name = strdup(name);
+	s->fd = fd;
+	s->wd = -1;
+	s->stream = stream;
+	s->capture_fd = -1;
+	s->last_active = w->tick;
+	wheel_insert(w, s, w->tick + idle_timeout);
+	w->sessions++;
+
+	if (stream) {
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN | EPOLLRDHUP;
+		ev.data.ptr = s;
+		epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+	}
+	return s;
+}
+
+/* Close the session; the session is freed by session_release after the events
+   batch because the later events of the batch may still point to it */
+static void session_close(Worker* w, Session* s, const char* reason)
+{
+	if (s->log) {
+		/* the log is over, process the last line without the line end */
+		cyberiada_ursula_log_session_finish(s->log);
+	}
+	session_report(s, reason);
+	if (s->stream && s->log) {
+		/* send the result back to the stream client */
+		UrsulaLogCheckerResult result = URSULA_CHECK_RESULT_ERROR;
+		char* result_code = NULL;
+		char reply[MAX_HEADER_LEN];
+		int len;
+		cyberiada_ursula_log_session_result(s->log, s->salt, &result, &result_code);
+		len = snprintf(reply, sizeof(reply), "%d%c%s%c%s\n",
+					   result, DELIMITER, result_code ? result_code : "", DELIMITER, reason);
+		if (write(s->fd, reply, len) != len) {
+			fprintf(stderr, "Cannot send the result to %s\n", s->name);
+		}
+		if (result_code) free(result_code);
+	}
+	if (s->capture_fd >= 0) close(s->capture_fd);
+	wheel_remove(w, s);
+	if (s->wd >= 0) {
+		Session** p = w->watches + s->wd;
+		while (*p != s) {
+			p = &((*p)->watch_next);
+		}
+		*p = s->watch_next;
+		if (!w->watches[s->wd]) {
+			/* the last session following the file */
+			inotify_rm_watch(w->inotify_fd, s->wd);
+		}
+	}
+	if (s->stream) {
+		epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+	}
+	close(s->fd);
+	if (s->log) cyberiada_ursula_log_session_free(s->log);
+	s->log = NULL;
+	s->closed = 1;
+	s->closed_next = w->closed;
+	w->closed = s;
+	w->sessions--;
+}
+
+static void session_release(Worker* w)
+{
+	while (w->closed) {
+		Session* s = w->closed;
+		w->closed = s->closed_next;
+		free(s->name);
+		free(s);
+	}
+}
+
+/* Read the push stream header "task-id:salt\n" (it may come in parts).
+   Returns the number of the header bytes consumed or -1 on the bad header */
+static ssize_t session_stream_header(Worker* w, Session* s, const char* data, size_t size)
+{
+	const char* eol = (const char*)memchr(data, '\n', size);
+	size_t len = eol ? (size_t)(eol - data) : size;
+	char* d;
+
+	if (s->header_len + len >= MAX_HEADER_LEN) {
+		return -1;
+	}
+	memcpy(s->task_id + s->header_len, data, len);
+	s->header_len += len;
+	s->task_id[s->header_len] = 0;
+	if (!eol) {
+		return len;
+	}
+
+	d = strchr(s->task_id, DELIMITER);
+	if (!d) {
+		return -1;
+	}
+	*d = 0;
+	s->salt = atoi(d + 1);
+	if (cyberiada_ursula_log_session_new(w->checker, s->task_id, &(s->log)) != URSULA_CHECK_NO_ERROR) {
+		return -1;
+	}
+	s->capture_fd = capture_stream(s->task_id, s->salt);
+	return len + 1;
+}
+
+/* Read the available data, returns 0 if the session should be closed */
+static int session_read(Worker* w, Session* s)
+{
+	char buffer[READ_BUFFER_SIZE];
+	ssize_t n;
+
+	for (;;) {
+		ssize_t offset = 0;
+
+		n = read(s->fd, buffer, sizeof(buffer));
+		if (n < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		}
+		if (n == 0) {
+			/* the end of the stream or the end of the followed file so far */
+			return !s->stream;
+		}
+		s->last_active = w->tick;
+
+		if (!s->stream && !s->captured) {
+			/* the followed file job arrives with its first data */
+			capture_record(s->task_id, s->salt, s->name);
+			s->captured = 1;
+		}
+		if (!s->log) {
+			offset = session_stream_header(w, s, buffer, n);
+			if (offset < 0) {
+				fprintf(stderr, "Bad stream header from %s\n", s->name);
+				return 0;
+			}
+			if (!s->log) {
+				continue;
+			}
+		}
+		if (s->capture_fd >= 0 && write(s->capture_fd, buffer + offset, n - offset) != n - offset) {
+			fprintf(stderr, "Cannot capture the log of %s\n", s->name);
+			close(s->capture_fd);
+			s->capture_fd = -1;
+		}
+		cyberiada_ursula_log_session_feed(s->log, buffer + offset, n - offset);
+		if (cyberiada_ursula_log_session_state(s->log) >= URSULA_SESSION_ENDED) {
+			return 0;
+		}
+	}
+}
+
+static int session_follow_file(Worker* w, const char* task_id, int salt, const char* path)
+{
+	Session* s;
+	int fd, wd;
+
+	fd = open(path, O_RDONLY | O_NONBLOCK);
+	if (fd < 0) {
+		fprintf(stderr, "Cannot open log file %s\n", path);
+		return -1;
+	}
+	wd = inotify_add_watch(w->inotify_fd, path, IN_MODIFY);
+	if (wd < 0) {
+		fprintf(stderr, "Cannot watch log file %s\n", path);
+		close(fd);
+		return -1;
+	}
+
+	if ((size_t)wd >= w->watches_size) {
+		size_t size = w->watches_size ? w->watches_size : 64;
+		while (size <= (size_t)wd) size *= 2;
+		w->watches = (Session**)realloc(w->watches, sizeof(Session*) * size);
+		memset(w->watches + w->watches_size, 0, sizeof(Session*) * (size - w->watches_size));
+		w->watches_size = size;
+	}
+
+	s = session_new(w, path, fd, 0);
+	/* the watch is the same for the sessions following the same file */
+	s->wd = wd;
+	s->watch_next = w->watches[wd];
+	w->watches[wd] = s;
+	strncpy(s->task_id, task_id, MAX_HEADER_LEN - 1);
+	s->salt = salt;
+	if (cyberiada_ursula_log_session_new(w->checker, task_id, &(s->log)) != URSULA_CHECK_NO_ERROR) {
+		session_close(w, s, "error");
+		return -1;
+	}
+
+	/* read the file content written so far */
+	if (!session_read(w, s)) {
+		session_close(w, s, cyberiada_ursula_log_session_state(s->log) == URSULA_SESSION_ENDED ? "ended" : "error");
+	}
+	return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * The workers
+ * ----------------------------------------------------------------------------- */
+
+static void worker_accept(Worker* w)
+{
+	for (;;) {
+		struct sockaddr_in addr;
+		socklen_t addr_len = sizeof(addr);
+		char name[64];
+		unsigned char* ip;
+		int fd = accept(w->listen_fd, (struct sockaddr*)&addr, &addr_len);
+		if (fd < 0) {
+			return;
+		}
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		ip = (unsigned char*)&addr.sin_addr.s_addr;
+		snprintf(name, sizeof(name), "%u.%u.%u.%u/%u/%d",
+				 ip[0], ip[1], ip[2], ip[3], ntohs(addr.sin_port), fd);
+		session_new(w, name, fd, 1);
+	}
+}
+
+static void worker_inotify(Worker* w)
+{
+	char buffer[READ_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+	ssize_t n;
+
+	while ((n = read(w->inotify_fd, buffer, sizeof(buffer))) > 0) {
+		char* p = buffer;
+		while (p < buffer + n) {
+			struct inotify_event* event = (struct inotify_event*)p;
+			p += sizeof(struct inotify_event) + event->len;
+			if (event->wd >= 0 && (size_t)event->wd < w->watches_size) {
+				Session* s = w->watches[event->wd];
+				while (s) {
+					/* the closed session is removed from the list */
+					Session* next = s->watch_next;
+					if (!session_read(w, s)) {
+						session_close(w, s,
+									  cyberiada_ursula_log_session_state(s->log) == URSULA_SESSION_ENDED ? "ended" : "error");
+					}
+					s = next;
+				}
+			}
+		}
+	}
+}
+
+static void worker_report(Worker* w)
+{
+	size_t i, memory = 0;
+	for (i = 0; i < WHEEL_SLOTS; i++) {
+		Session* s;
+		for (s = w->wheel[i]; s; s = s->wheel_next) {
+			memory += session_memory(s);
+		}
+	}
+	fprintf(stderr, "Worker %lu: sessions %lu, memory %lu bytes, %lu bytes per session\n",
+			w->n, w->sessions, memory, w->sessions ? memory / w->sessions : 0);
+}
+
+static void worker_tick(Worker* w)
+{
+	unsigned long long expirations;
+	Session* s;
+
+	if (read(w->timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+		return;
+	}
+	while (expirations--) {
+		w->tick++;
+		s = w->wheel[w->tick % WHEEL_SLOTS];
+		while (s) {
+			Session* next = s->wheel_next;
+			unsigned long expires = s->last_active + idle_timeout;
+			if (expires <= w->tick) {
+				session_close(w, s, "idle");
+			} else if (expires % WHEEL_SLOTS != w->tick % WHEEL_SLOTS) {
+				/* the session was active, move it to the new expiration slot */
+				wheel_remove(w, s);
+				wheel_insert(w, s, expires);
+			}
+			s = next;
+		}
+		if (report_period && w->tick % report_period == 0) {
+			worker_report(w);
+		}
+	}
+}
+
+static int worker_init(Worker* w, size_t n, UrsulaLogCheckerData* checker, int listen_fd)
+{
+	struct epoll_event ev;
+	struct itimerspec ts;
+
+	memset(w, 0, sizeof(Worker));
+	w->n = n;
+	w->checker = checker;
+	w->listen_fd = listen_fd;
+	w->listen_handle.type = hListen;
+	w->inotify_handle.type = hInotify;
+	w->timer_handle.type = hTimer;
+
+	w->epoll_fd = epoll_create1(0);
+	w->inotify_fd = inotify_init1(IN_NONBLOCK);
+	w->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	if (w->epoll_fd < 0 || w->inotify_fd < 0 || w->timer_fd < 0) {
+		return -1;
+	}
+
+	memset(&ts, 0, sizeof(ts));
+	ts.it_value.tv_sec = ts.it_interval.tv_sec = 1;
+	timerfd_settime(w->timer_fd, 0, &ts, NULL);
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = &(w->inotify_handle);
+	epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, w->inotify_fd, &ev);
+	ev.data.ptr = &(w->timer_handle);
+	epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, w->timer_fd, &ev);
+	if (listen_fd >= 0) {
+		/* wake up only one of the workers on the new connection */
+		ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+		ev.data.ptr = &(w->listen_handle);
+		epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+	}
+	return 0;
+}
+
+static void worker_free(Worker* w)
+{
+	size_t i;
+	for (i = 0; i < WHEEL_SLOTS; i++) {
+		while (w->wheel[i]) {
+			session_close(w, w->wheel[i], "stopped");
+		}
+	}
+	session_release(w);
+	if (w->watches) free(w->watches);
+	if (w->timer_fd >= 0) close(w->timer_fd);
+	if (w->inotify_fd >= 0) close(w->inotify_fd);
+	if (w->epoll_fd >= 0) close(w->epoll_fd);
+}
+
+static void* worker_run(void* arg)
+{
+	Worker* w = (Worker*)arg;
+	struct epoll_event events[MAX_EVENTS];
+
+	while (!stop) {
+		int i, n = epoll_wait(w->epoll_fd, events, MAX_EVENTS, -1);
+		for (i = 0; i < n; i++) {
+			Handle* h = (Handle*)events[i].data.ptr;
+			if (h->type == hListen) {
+				worker_accept(w);
+			} else if (h->type == hInotify) {
+				worker_inotify(w);
+			} else if (h->type == hTimer) {
+				worker_tick(w);
+			} else {
+				Session* s = (Session*)h;
+				if (s->closed) {
+					/* closed by the timer earlier in this batch */
+					continue;
+				}
+				if (!session_read(w, s) || (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+					int state = s->log ? cyberiada_ursula_log_session_state(s->log) : URSULA_SESSION_SCENE;
+					session_close(w, s,
+								  state == URSULA_SESSION_ENDED ? "ended" :
+								  state == URSULA_SESSION_ERROR ? "error" : "closed");
+				}
+			}
+		}
+		session_release(w);
+	}
+	return NULL;
+}
+
+/* -----------------------------------------------------------------------------
+ * The monitor program
+ * ----------------------------------------------------------------------------- */
+
+static void print_usage(const char* name)
+{
+	fprintf(stderr, "Usage: %s <config-file> [-t threads] [-i idle-timeout] [-r report-period] [-p port] [-f sessions-file] [-c capture-dir]\n", name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "The sessions file lines: task-id:salt:log-file (the log files are followed)\n");
+	fprintf(stderr, "The push stream starts with the line task-id:salt followed by the log lines\n");
+	fprintf(stderr, "The stream client gets the line result:code:reason when the session is closed\n");
+	fprintf(stderr, "Results: name:task-id:salt:result:code:reason:memory\n");
+	fprintf(stderr, "The capture (%s in the capture dir): arrival-time-ms:task-id:salt:log-file\n", CAPTURE_FILE);
+	fprintf(stderr, "\n");
+}
+
+static int open_listen_socket(int port)
+{
+	struct sockaddr_in addr;
+	int one = 1;
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int load_sessions(Worker* workers, size_t threads, const char* sessions_file)
+{
+	FILE* f = fopen(sessions_file, "r");
+	char* buffer = NULL;
+	size_t size = 0, n = 0;
+	ssize_t strsize;
+
+	if (!f) {
+		fprintf(stderr, "Cannot open sessions file %s\n", sessions_file);
+		return -1;
+	}
+	while ((strsize = getline(&buffer, &size, f)) > 0) {
+		char *salt, *path;
+		if (buffer[strsize - 1] == '\n') {
+			buffer[strsize - 1] = 0;
+		}
+		salt = strchr(buffer, DELIMITER);
+		if (!salt) continue;
+		*salt++ = 0;
+		path = strchr(salt, DELIMITER);
+		if (!path || !*(path + 1)) continue;
+		*path++ = 0;
+		/* distribute the files between the workers */
+		session_follow_file(workers + n % threads, buffer, atoi(salt), path);
+		n++;
+	}
+	free(buffer);
+	fclose(f);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char *config_file = NULL, *sessions_file = NULL;
+	size_t threads = DEFAULT_THREADS, i;
+	int port = 0, listen_fd = -1, opt, sig;
+	UrsulaLogCheckerData* checker = NULL;
+	Worker* workers;
+	sigset_t sigs;
+	int res;
+
+	while ((opt = getopt(argc, argv, "t:i:r:p:f:c:")) != -1) {
+		switch (opt) {
+		case 't': threads = atoi(optarg); break;
+		case 'i': idle_timeout = atol(optarg); break;
+		case 'r': report_period = atol(optarg); break;
+		case 'p': port = atoi(optarg); break;
+		case 'f': sessions_file = optarg; break;
+		case 'c': capture_dir = optarg; break;
+		default:
+			print_usage(argv[0]);
+			return 99;
+		}
+	}
+	if (optind != argc - 1 || threads == 0 || idle_timeout == 0 || (!port && !sessions_file)) {
+		print_usage(argv[0]);
+		return 99;
+	}
+	config_file = argv[optind];
+
+	res = cyberiada_ursula_log_checker_init(&checker, config_file);
+	if (res != URSULA_CHECK_NO_ERROR) {
+		fprintf(stderr, "Cannot initialize Ursula log checker library: %d\n", res);
+		return res;
+	}
+
+	if (capture_dir && capture_open() < 0) {
+		fprintf(stderr, "Cannot open the capture in %s\n", capture_dir);
+		cyberiada_ursula_log_checker_free(checker);
+		return 1;
+	}
+
+	if (port) {
+		listen_fd = open_listen_socket(port);
+		if (listen_fd < 0) {
+			fprintf(stderr, "Cannot listen on port %d\n", port);
+			cyberiada_ursula_log_checker_free(checker);
+			return 1;
+		}
+	}
+
+	/* the workers inherit the blocked signals, the main thread waits for them */
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	workers = (Worker*)malloc(sizeof(Worker) * threads);
+	for (i = 0; i < threads; i++) {
+		if (worker_init(workers + i, i, checker, listen_fd) != 0) {
+			fprintf(stderr, "Cannot initialize worker %lu\n", i);
+			return 1;
+		}
+	}
+	if (sessions_file) {
+		load_sessions(workers, threads, sessions_file);
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_create(&(workers[i].thread), NULL, worker_run, workers + i);
+	}
+
+	sigwait(&sigs, &sig);
+	stop = 1;
+
+	for (i = 0; i < threads; i++) {
+		/* the workers check the stop flag on the next timer tick */
+		pthread_join(workers[i].thread, NULL);
+		worker_free(workers + i);
+	}
+	free(workers);
+
+	if (listen_fd >= 0) close(listen_fd);
+	if (capture_fd >= 0) close(capture_fd);
+	cyberiada_ursula_log_checker_free(checker);
+
+	return 0;
+}
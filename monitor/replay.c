@@ -0,0 +1,409 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The captured job stream replay program
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+/* -----------------------------------------------------------------------------
+ * The replay constants
+ * ----------------------------------------------------------------------------- */
+
+#define DEFAULT_HOST           "127.0.0.1"
+#define DEFAULT_CONCURRENCY    16
+#define MAX_EVENTS             64
+#define MAX_HEADER_LEN         256
+#define MAX_REPLY_LEN          256
+#define DELIMITER              ':'
+#define REPLY_ERROR            "error"
+
+/* -----------------------------------------------------------------------------
+ * The replay structures
+ * ----------------------------------------------------------------------------- */
+
+typedef struct {
+	double        arrival;                  /* the arrival time relative to the first job (seconds) */
+	char          header[MAX_HEADER_LEN];   /* the stream header task-id:salt */
+	size_t        header_size;
+	char*         log;                      /* the log content */
+	size_t        log_size;
+} Job;
+
+typedef struct {
+	Job*          job;
+	int           fd;
+	size_t        sent;                     /* the header and the log bytes sent */
+	double        start;                    /* the latency start (the scheduled time in the open loop) */
+	char          reply[MAX_REPLY_LEN];
+	size_t        reply_size;
+} Connection;
+
+/* -----------------------------------------------------------------------------
+ * The utils
+ * ----------------------------------------------------------------------------- */
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
+
+static int compare_job(const void* a, const void* b)
+{
+	return compare_double(&(((const Job*)a)->arrival), &(((const Job*)b)->arrival));
+}
+
+static char* read_file(const char* path, size_t* size)
+{
+	FILE* f = fopen(path, "rb");
+	char* content;
+	long len;
+	if (!f) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	content = (char*)malloc(len > 0 ? len : 1);
+	*size = fread(content, 1, len, f);
+	fclose(f);
+	return content;
+}
+
+/* Load the capture records arrival-time-ms:task-id:salt:log-file */
+static Job* load_jobs(const char* capture_file, size_t* count)
+{
+	FILE* f = fopen(capture_file, "r");
+	char* buffer = NULL;
+	size_t size = 0, n = 0, capacity = 0, i;
+	ssize_t strsize;
+	Job* jobs = NULL;
+
+	if (!f) {
+		fprintf(stderr, "Cannot open capture file %s\n", capture_file);
+		return NULL;
+	}
+	while ((strsize = getline(&buffer, &size, f)) > 0) {
+		char *task, *salt, *path;
+		unsigned long long arrival;
+		Job* job;
+
+		if (buffer[strsize - 1] == '\n') {
+			buffer[strsize - 1] = 0;
+		}
+		task = strchr(buffer, DELIMITER);
+		if (!task) continue;
+		*task++ = 0;
+		salt = strchr(task, DELIMITER);
+		if (!salt) continue;
+		*salt++ = 0;
+		path = strchr(salt, DELIMITER);
+		if (!path) continue;
+		*path++ = 0;
+
+		if (n == capacity) {
+			capacity = capacity ? capacity * 2 : 256;
+			jobs = (Job*)realloc(jobs, sizeof(Job) * capacity);
+		}
+		job = jobs + n;
+		arrival = strtoull(buffer, NULL, 10);
+		job->arrival = arrival / 1000.0;
+		job->header_size = snprintf(job->header, MAX_HEADER_LEN, "%s%c%s\n", task, DELIMITER, salt);
+		job->log = read_file(path, &(job->log_size));
+		if (!job->log || job->header_size >= MAX_HEADER_LEN) {
+			fprintf(stderr, "Cannot read the captured log %s\n", path);
+			if (job->log) free(job->log);
+			continue;
+		}
+		n++;
+	}
+	free(buffer);
+	fclose(f);
+
+	/* the workers append the records concurrently, so the records are not
+	   ordered by the arrival time */
+	if (n) {
+		double first;
+		qsort(jobs, n, sizeof(Job), compare_job);
+		first = jobs[0].arrival;
+		for (i = 0; i < n; i++) {
+			jobs[i].arrival -= first;
+		}
+	}
+	*count = n;
+	return jobs;
+}
+
+/* -----------------------------------------------------------------------------
+ * The connections
+ * ----------------------------------------------------------------------------- */
+
+static Connection* connection_start(int epoll_fd, struct sockaddr_in* addr, Job* job, double start)
+{
+	Connection* c;
+	struct epoll_event ev;
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		return NULL;
+	}
+	if (connect(fd, (struct sockaddr*)addr, sizeof(*addr)) < 0 && errno != EINPROGRESS) {
+		close(fd);
+		return NULL;
+	}
+	c = (Connection*)malloc(sizeof(Connection));
+	memset(c, 0, sizeof(Connection));
+	c->job = job;
+	c->fd = fd;
+	c->start = start;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLOUT | EPOLLIN;
+	ev.data.ptr = c;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+	return c;
+}
+
+/* Send the next part of the job, returns -1 on error */
+static int connection_send(int epoll_fd, Connection* c)
+{
+	Job* job = c->job;
+	size_t total = job->header_size + job->log_size;
+	while (c->sent < total) {
+		ssize_t n;
+		if (c->sent < job->header_size) {
+			n = write(c->fd, job->header + c->sent, job->header_size - c->sent);
+		} else {
+			n = write(c->fd, job->log + c->sent - job->header_size, total - c->sent);
+		}
+		if (n < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+		}
+		c->sent += n;
+	}
+	if (c->sent == total) {
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = c;
+		epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+		shutdown(c->fd, SHUT_WR);
+		c->sent++;
+	}
+	return 0;
+}
+
+/* Read the reply result:code:reason, returns 1 if the job is completed,
+   2 if the monitor replied with the error reason, -1 on error */
+static int connection_receive(Connection* c)
+{
+	for (;;) {
+		ssize_t n = read(c->fd, c->reply + c->reply_size, MAX_REPLY_LEN - 1 - c->reply_size);
+		if (n < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+		}
+		if (n == 0 || c->reply_size + n >= MAX_REPLY_LEN - 1) {
+			char *eol, *reason;
+			c->reply[c->reply_size] = 0;
+			eol = strchr(c->reply, '\n');
+			if (!c->reply_size || !eol) {
+				return -1;
+			}
+			*eol = 0;
+			reason = strrchr(c->reply, DELIMITER);
+			return reason && strcmp(reason + 1, REPLY_ERROR) == 0 ? 2 : 1;
+		}
+		c->reply_size += n;
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * The replay program
+ * ----------------------------------------------------------------------------- */
+
+static void print_usage(const char* name)
+{
+	fprintf(stderr, "Usage: %s <capture-file> [-h host] -p port [-m open|closed] [-s rate-scale] [-c concurrency]\n", name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "open   - send the jobs on the captured arrival times divided by the rate scale\n");
+	fprintf(stderr, "closed - keep the concurrency number of the jobs in flight\n");
+	fprintf(stderr, "\n");
+}
+
+static void print_report(double* latencies, size_t completed, size_t failed, size_t errors, double duration)
+{
+	static const double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+	size_t i;
+
+	printf("Jobs: %lu completed (%lu error replies), %lu errors\n", completed, failed, errors);
+	printf("Duration: %.3f s\n", duration);
+	printf("Throughput: %.1f jobs/s\n", duration > 0 ? completed / duration : 0.0);
+	if (!completed) {
+		return;
+	}
+	qsort(latencies, completed, sizeof(double), compare_double);
+	for (i = 0; i < sizeof(percentiles) / sizeof(double); i++) {
+		size_t k = (size_t)(percentiles[i] / 100.0 * (completed - 1) + 0.5);
+		printf("Latency p%g: %.3f ms\n", percentiles[i], latencies[k] * 1000.0);
+	}
+	printf("Latency max: %.3f ms\n", latencies[completed - 1] * 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+	const char *capture_file = NULL, *host = DEFAULT_HOST;
+	char closed_loop = 0;
+	double scale = 1.0, started, finished;
+	size_t concurrency = DEFAULT_CONCURRENCY, jobs_count = 0, next = 0, in_flight = 0;
+	size_t completed = 0, failed = 0, errors = 0, i;
+	int port = 0, opt, epoll_fd;
+	struct sockaddr_in addr;
+	double* latencies;
+	Job* jobs;
+
+	while ((opt = getopt(argc, argv, "h:p:m:s:c:")) != -1) {
+		switch (opt) {
+		case 'h': host = optarg; break;
+		case 'p': port = atoi(optarg); break;
+		case 'm': closed_loop = strcmp(optarg, "closed") == 0; break;
+		case 's': scale = atof(optarg); break;
+		case 'c': concurrency = atoi(optarg); break;
+		default:
+			print_usage(argv[0]);
+			return 99;
+		}
+	}
+	if (optind != argc - 1 || !port || scale <= 0 || concurrency == 0) {
+		print_usage(argv[0]);
+		return 99;
+	}
+	capture_file = argv[optind];
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+		fprintf(stderr, "Bad host address %s\n", host);
+		return 1;
+	}
+
+	jobs = load_jobs(capture_file, &jobs_count);
+	if (!jobs_count) {
+		fprintf(stderr, "No jobs to replay\n");
+		return 1;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	epoll_fd = epoll_create1(0);
+	latencies = (double*)malloc(sizeof(double) * jobs_count);
+	started = now();
+
+	while (completed + errors < jobs_count) {
+		struct epoll_event events[MAX_EVENTS];
+		int timeout = -1, n, k;
+		double t = now();
+
+		/* dispatch the jobs */
+		while (next < jobs_count) {
+			double scheduled = started + jobs[next].arrival / scale;
+			if (closed_loop ? in_flight >= concurrency : scheduled > t) {
+				if (!closed_loop) {
+					timeout = (int)((scheduled - t) * 1000.0) + 1;
+				}
+				break;
+			}
+			/* the open loop latency counts from the scheduled time, so the
+			   server delays are not hidden by the late sending */
+			if (connection_start(epoll_fd, &addr, jobs + next, closed_loop ? t : scheduled)) {
+				in_flight++;
+			} else {
+				errors++;
+			}
+			next++;
+		}
+
+		if (!in_flight) {
+			if (next < jobs_count) {
+				usleep(timeout > 0 ? timeout * 1000 : 1000);
+			}
+			continue;
+		}
+
+		n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+		for (k = 0; k < n; k++) {
+			Connection* c = (Connection*)events[k].data.ptr;
+			int res = 0;
+			if (events[k].events & EPOLLOUT) {
+				res = connection_send(epoll_fd, c);
+			}
+			if (res == 0 && (events[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+				res = connection_receive(c);
+			}
+			if (res != 0) {
+				if (res > 0) {
+					/* the error replies are counted, but their latency is measured too */
+					latencies[completed++] = now() - c->start;
+					if (res == 2) {
+						failed++;
+					}
+				} else {
+					errors++;
+				}
+				epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+				close(c->fd);
+				free(c);
+				in_flight--;
+			}
+		}
+	}
+	finished = now();
+
+	printf("Mode: %s", closed_loop ? "closed" : "open");
+	if (closed_loop) {
+		printf(", concurrency %lu\n", concurrency);
+	} else {
+		printf(", rate scale %g\n", scale);
+	}
+	print_report(latencies, completed, failed, errors, finished - started);
+
+	for (i = 0; i < jobs_count; i++) {
+		free(jobs[i].log);
+	}
+	free(jobs);
+	free(latencies);
+	close(epoll_fd);
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,417 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The benchmark program
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "ursulalogcheck.h"
+
+#define DEFAULT_ITERATIONS 1000
+#define MAX_PATH_LEN       4096
+#define LOG_SUFFIX         ".log"
+#define CAPTURE_SUFFIX     ".csv"
+#define DELIMITER          ':'
+#define TOTAL_STR          "total"
+#define CHECKS_STR         "checks"
+
+/* The benchmark job: the monitor capture records carry their own task and salt */
+typedef struct {
+	char* task_id;
+	int salt;
+	char* log_file;
+} BenchJob;
+
+typedef struct {
+	BenchJob* jobs;
+	size_t count;
+	size_t capacity;
+} BenchCorpus;
+
+static const char* PHASE_STR[URSULA_CHECK_PHASES_COUNT] = {
+	"scene",
+	"events",
+	"eval",
+	"hash"
+};
+
+static void print_usage(const char* name)
+{
+	fprintf(stderr, "Usage: %s <config-file> <task-id> <log-file|corpus-dir|capture%s> [iterations]\n"
+			"       [-o stats-file] [-b baseline-stats-file] [-e]\n", name, CAPTURE_SUFFIX);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "The corpus directory is checked as the %s files of the task <task-id>.\n", LOG_SUFFIX);
+	fprintf(stderr, "The monitor capture file records use their own task ids and salts.\n");
+	fprintf(stderr, "The iterations are the passes over the whole corpus.\n");
+	fprintf(stderr, "The -e option counts the logs failed to check instead of stopping (the fuzz inputs).\n");
+	fprintf(stderr, "\n");
+}
+
+static int corpus_add(BenchCorpus* corpus, const char* task_id, int salt, const char* log_file)
+{
+	BenchJob* job;
+	if (corpus->count == corpus->capacity) {
+		size_t capacity = corpus->capacity ? corpus->capacity * 2 : 64;
+		BenchJob* jobs = (BenchJob*)realloc(corpus->jobs, sizeof(BenchJob) * capacity);
+		if (!jobs) {
+			return -1;
+		}
+		corpus->jobs = jobs;
+		corpus->capacity = capacity;
+	}
+	job = corpus->jobs + corpus->count;
+	job->task_id = strdup(task_id);
+	job->salt = salt;
+	job->log_file = strdup(log_file);
+	if (!job->task_id || !job->log_file) {
+		if (job->task_id) free(job->task_id);
+		if (job->log_file) free(job->log_file);
+		return -1;
+	}
+	corpus->count++;
+	return 0;
+}
+
+static void corpus_free(BenchCorpus* corpus)
+{
+	size_t i;
+	for (i = 0; i < corpus->count; i++) {
+		free(corpus->jobs[i].task_id);
+		free(corpus->jobs[i].log_file);
+	}
+	if (corpus->jobs) free(corpus->jobs);
+}
+
+static int has_suffix(const char* s, const char* suffix)
+{
+	size_t len = strlen(s), suffix_len = strlen(suffix);
+	return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+/* capture record: arrival-ms:task-id:salt:log-file */
+static int corpus_load_capture(BenchCorpus* corpus, const char* capture_file)
+{
+	char line[MAX_PATH_LEN * 2];
+	FILE* f = fopen(capture_file, "r");
+	if (!f) {
+		fprintf(stderr, "Cannot open capture file %s\n", capture_file);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		char *task_id, *salt, *log_file, *d;
+		d = line + strlen(line);
+		while (d > line && (d[-1] == '\n' || d[-1] == '\r')) *--d = 0;
+		task_id = strchr(line, DELIMITER);
+		if (!task_id) continue;
+		*task_id++ = 0;
+		salt = strchr(task_id, DELIMITER);
+		if (!salt) continue;
+		*salt++ = 0;
+		log_file = strchr(salt, DELIMITER);
+		if (!log_file) continue;
+		*log_file++ = 0;
+		if (corpus_add(corpus, task_id, atoi(salt), log_file) != 0) {
+			fclose(f);
+			return -1;
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
+static int compare_jobs(const void* a, const void* b)
+{
+	return strcmp(((const BenchJob*)a)->log_file, ((const BenchJob*)b)->log_file);
+}
+
+static int corpus_load_dir(BenchCorpus* corpus, const char* task_id, const char* dir)
+{
+	char path[MAX_PATH_LEN];
+	struct dirent* entry;
+	DIR* d = opendir(dir);
+	if (!d) {
+		fprintf(stderr, "Cannot open corpus directory %s\n", dir);
+		return -1;
+	}
+	while ((entry = readdir(d)) != NULL) {
+		if (!has_suffix(entry->d_name, LOG_SUFFIX)) continue;
+		snprintf(path, MAX_PATH_LEN, "%s/%s", dir, entry->d_name);
+		if (corpus_add(corpus, task_id, 0, path) != 0) {
+			closedir(d);
+			return -1;
+		}
+	}
+	closedir(d);
+	/* the same order on every run */
+	qsort(corpus->jobs, corpus->count, sizeof(BenchJob), compare_jobs);
+	return 0;
+}
+
+static int corpus_load(BenchCorpus* corpus, const char* task_id, const char* path)
+{
+	struct stat st;
+	if (stat(path, &st) != 0) {
+		fprintf(stderr, "Cannot find corpus %s\n", path);
+		return -1;
+	}
+	if (S_ISDIR(st.st_mode)) {
+		return corpus_load_dir(corpus, task_id, path);
+	} else if (has_suffix(path, CAPTURE_SUFFIX)) {
+		return corpus_load_capture(corpus, path);
+	} else {
+		return corpus_add(corpus, task_id, 0, path);
+	}
+}
+
+/* The number of the checks run: the failed checks time is in the phases too */
+static unsigned long long stats_checks(const UrsulaLogCheckerStats* stats)
+{
+	unsigned long long checks = stats->checks + stats->failed_checks;
+	return checks ? checks : 1;
+}
+
+static void print_stats(const UrsulaLogCheckerStats* stats, int counters)
+{
+	unsigned long long checks = stats_checks(stats);
+	size_t i;
+
+	printf("Checks: %llu (failed %llu)\n", stats->checks + stats->failed_checks, stats->failed_checks);
+	if (counters) {
+		printf("%-8s %12s %14s %14s %6s %12s %12s\n",
+			   "phase", "ns/check", "cycles/check", "instr/check", "IPC", "llc-miss/ch", "br-miss/ch");
+	} else {
+		printf("%-8s %12s\n", "phase", "ns/check");
+	}
+	for (i = 0; i < URSULA_CHECK_PHASES_COUNT; i++) {
+		const UrsulaLogCheckerPhaseStats* phase = stats->phases + i;
+		if (counters) {
+			printf("%-8s %12llu %14llu %14llu %6.2f %12llu %12llu\n",
+				   PHASE_STR[i],
+				   phase->time_ns / checks,
+				   phase->cycles / checks,
+				   phase->instructions / checks,
+				   phase->cycles ? (double)phase->instructions / phase->cycles : 0.0,
+				   phase->cache_misses / checks,
+				   phase->branch_misses / checks);
+		} else {
+			printf("%-8s %12llu\n", PHASE_STR[i], phase->time_ns / checks);
+		}
+	}
+}
+
+
+/* The stats file is the phase:ns-per-check lines of the saved run */
+static int save_stats(const char* stats_file, const UrsulaLogCheckerStats* stats, unsigned long long total_ns)
+{
+	unsigned long long checks = stats_checks(stats);
+	size_t i;
+	FILE* f = fopen(stats_file, "w");
+	if (!f) {
+		fprintf(stderr, "Cannot open stats file %s\n", stats_file);
+		return -1;
+	}
+	fprintf(f, "%s%c%llu\n", CHECKS_STR, DELIMITER, stats->checks + stats->failed_checks);
+	fprintf(f, "%s%c%llu\n", TOTAL_STR, DELIMITER, total_ns / checks);
+	for (i = 0; i < URSULA_CHECK_PHASES_COUNT; i++) {
+		fprintf(f, "%s%c%llu\n", PHASE_STR[i], DELIMITER, stats->phases[i].time_ns / checks);
+	}
+	fclose(f);
+	return 0;
+}
+
+static void print_gain_line(const char* name, unsigned long long baseline, unsigned long long current)
+{
+	if (baseline) {
+		printf("%-8s %12llu %12llu %+9.2f%%\n", name, baseline, current,
+			   ((double)baseline - (double)current) * 100.0 / baseline);
+	} else {
+		printf("%-8s %12s %12llu %10s\n", name, "-", current, "-");
+	}
+}
+
+static int print_gain(const char* baseline_file, const UrsulaLogCheckerStats* stats, unsigned long long total_ns)
+{
+	unsigned long long checks = stats_checks(stats);
+	unsigned long long baseline_total = 0, baseline_phases[URSULA_CHECK_PHASES_COUNT];
+	char line[256];
+	size_t i;
+	FILE* f = fopen(baseline_file, "r");
+	if (!f) {
+		fprintf(stderr, "Cannot open baseline stats file %s\n", baseline_file);
+		return -1;
+	}
+	memset(baseline_phases, 0, sizeof(baseline_phases));
+	while (fgets(line, sizeof(line), f)) {
+		char* d = strchr(line, DELIMITER);
+		if (!d) continue;
+		*d++ = 0;
+		if (strcmp(line, TOTAL_STR) == 0) {
+			baseline_total = strtoull(d, NULL, 10);
+			continue;
+		}
+		for (i = 0; i < URSULA_CHECK_PHASES_COUNT; i++) {
+			if (strcmp(line, PHASE_STR[i]) == 0) {
+				baseline_phases[i] = strtoull(d, NULL, 10);
+			}
+		}
+	}
+	fclose(f);
+
+	printf("Gain over %s:\n", baseline_file);
+	printf("%-8s %12s %12s %10s\n", "phase", "base ns", "ns/check", "gain");
+	print_gain_line(TOTAL_STR, baseline_total, total_ns / checks);
+	for (i = 0; i < URSULA_CHECK_PHASES_COUNT; i++) {
+		print_gain_line(PHASE_STR[i], baseline_phases[i], stats->phases[i].time_ns / checks);
+	}
+	return 0;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+	const char *config_file = NULL, *task_id = NULL, *corpus_path = NULL;
+	const char *stats_file = NULL, *baseline_file = NULL;
+	long iterations = DEFAULT_ITERATIONS, i;
+	UrsulaLogCheckerData* checker = NULL;
+	UrsulaLogCheckerResult result = 0;
+	UrsulaLogCheckerStats stats;
+	BenchCorpus corpus;
+	unsigned long long start, total_ns;
+	size_t j, errors = 0;
+	int counters = 1, positional = 0, a;
+	char keep_errors = 0;
+	int res = 0;
+
+	for (a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "-o") == 0 && a + 1 < argc) {
+			stats_file = argv[++a];
+		} else if (strcmp(argv[a], "-b") == 0 && a + 1 < argc) {
+			baseline_file = argv[++a];
+		} else if (strcmp(argv[a], "-e") == 0) {
+			keep_errors = 1;
+		} else if (positional == 0) {
+			config_file = argv[a];
+			positional++;
+		} else if (positional == 1) {
+			task_id = argv[a];
+			positional++;
+		} else if (positional == 2) {
+			corpus_path = argv[a];
+			positional++;
+		} else if (positional == 3) {
+			iterations = atol(argv[a]);
+			positional++;
+			if (iterations <= 0) {
+				print_usage(argv[0]);
+				return 99;
+			}
+		} else {
+			print_usage(argv[0]);
+			return 99;
+		}
+	}
+	if (positional < 3) {
+		print_usage(argv[0]);
+		return 99;
+	}
+
+	memset(&corpus, 0, sizeof(corpus));
+	if (corpus_load(&corpus, task_id, corpus_path) != 0 || !corpus.count) {
+		fprintf(stderr, "Cannot load the benchmark corpus %s\n", corpus_path);
+		corpus_free(&corpus);
+		return 99;
+	}
+
+	res = cyberiada_ursula_log_checker_init(&checker, config_file);
+	if (res != URSULA_CHECK_NO_ERROR) {
+		fprintf(stderr, "Cannot initialize Ursula log checker library: %d\n", res);
+		corpus_free(&corpus);
+		return res;
+	}
+
+	res = cyberiada_ursula_log_checker_enable_stats(checker,
+													URSULA_CHECK_STATS_TIME | URSULA_CHECK_STATS_COUNTERS);
+	if (res == URSULA_CHECK_NOT_SUPPORTED) {
+		fprintf(stderr, "Hardware performance counters are not available, timing only\n");
+		counters = 0;
+	} else if (res != URSULA_CHECK_NO_ERROR) {
+		fprintf(stderr, "Cannot enable statistics: %d\n", res);
+		cyberiada_ursula_log_checker_free(checker);
+		corpus_free(&corpus);
+		return res;
+	}
+
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < corpus.count; j++) {
+			const BenchJob* job = corpus.jobs + j;
+			char* result_code = NULL;
+			res = cyberiada_ursula_log_checker_check_log(checker,
+														 job->task_id,
+														 job->salt,
+														 job->log_file,
+														 &result,
+														 &result_code);
+			if (result_code) free(result_code);
+			if (res != URSULA_CHECK_NO_ERROR && keep_errors) {
+				if (i == 0) {
+					errors++;
+				}
+			} else if (res != URSULA_CHECK_NO_ERROR) {
+				fprintf(stderr, "Program checking error %d on the log %s\n", res, job->log_file);
+				cyberiada_ursula_log_checker_free(checker);
+				corpus_free(&corpus);
+				return res;
+			}
+		}
+	}
+	total_ns = now_ns() - start;
+
+	cyberiada_ursula_log_checker_get_stats(checker, &stats);
+	printf("Logs: %lu\n", corpus.count);
+	if (keep_errors) {
+		printf("Logs failed to check: %lu\n", errors);
+	}
+	printf("Last result code: %d\n", result);
+	printf("Total ns/check: %llu\n", total_ns / stats_checks(&stats));
+	print_stats(&stats, counters);
+
+	if (stats_file) {
+		save_stats(stats_file, &stats, total_ns);
+	}
+	if (baseline_file) {
+		print_gain(baseline_file, &stats, total_ns);
+	}
+
+	cyberiada_ursula_log_checker_free(checker);
+	corpus_free(&corpus);
+
+	return 0;
+}
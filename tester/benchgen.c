@@ -0,0 +1,204 @@
+/* -----------------------------------------------------------------------------
+ * The Cyberiada Ursula game engine log analyzer
+ *
+ * The synthetic benchmark corpus generator
+ *
+ * Copyright (C) 2025 Alexey Fedoseev <aleksey@fedoseev.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses/
+ * ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_TASK_ID      "bench"
+#define BENCH_CONFIG_FILE  "bench.cfg"
+#define BENCH_TASK_FILE    "bench.csv"
+#define DEFAULT_LOGS       64
+#define DEFAULT_STEPS      500
+#define MAX_MOBS           12
+#define MAX_CHESTS         3
+#define MAX_PATH_LEN       4096
+#define FIELD_SIZE         100
+#define BASE_X             10
+#define BASE_Y             10
+#define BASE_HP            30
+#define BASE_DAMAGE        5
+#define HIT_DAMAGE         10
+
+/* The task covers all condition types and the AND operand so the training
+   runs reach every evaluation path */
+static const char* BENCH_TASK_CSV =
+	"id:type:pri type:pri class:sec type:sec class:arg\n"
+	"base:mob:goblin:(10,10):30:5:\n"
+	"req:mob:goblin:1:12::\n"
+	"req:intobj:chest:1:3::\n"
+	"1:proxy:player::mob:goblin:20\n"
+	"2:approach:player::intobj:chest:0\n"
+	"3:move:mob:goblin:::0\n"
+	"3:retire:mob:goblin:player::0\n"
+	"4:attack:player::mob:goblin:0\n"
+	"5:damage:mob:goblin:::0\n"
+	"6:destroy:mob:goblin:::0\n"
+	"7:win::::::\n";
+
+typedef struct {
+	int x, y;
+	int hp;
+	char alive;
+} GenObject;
+
+static void print_usage(const char* name)
+{
+	fprintf(stderr, "Usage: %s <corpus-dir> [logs] [steps]\n", name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Writes %s, %s and the logs for the task '%s' to the corpus directory.\n",
+			BENCH_CONFIG_FILE, BENCH_TASK_FILE, BENCH_TASK_ID);
+	fprintf(stderr, "\n");
+}
+
+static int step(int v)
+{
+	return v + rand() % 3 - 1;
+}
+
+static int generate_log(const char* path, long steps)
+{
+	GenObject player, mobs[MAX_MOBS], chests[MAX_CHESTS];
+	size_t mobs_count = 1 + rand() % MAX_MOBS, chests_count = 1 + rand() % MAX_CHESTS, i;
+	size_t alive = mobs_count;
+	long t;
+	FILE* f = fopen(path, "w");
+
+	if (!f) {
+		fprintf(stderr, "Cannot open log file %s\n", path);
+		return -1;
+	}
+
+	player.x = player.y = 0;
+	fprintf(f, "Player Start Position (%d,%d)\n", player.x, player.y);
+	fprintf(f, "ID | Name | Object ID | Type | Position | HP | Damage\n");
+	for (i = 0; i < mobs_count; i++) {
+		/* the first mob is the base object */
+		mobs[i].x = i ? rand() % FIELD_SIZE : BASE_X;
+		mobs[i].y = i ? rand() % FIELD_SIZE : BASE_Y;
+		mobs[i].hp = BASE_HP;
+		mobs[i].alive = 1;
+		fprintf(f, "%lu | goblin | %lu | mob | (%d,%d) | %d | %d\n",
+				i + 1, 100 + i, mobs[i].x, mobs[i].y, mobs[i].hp, BASE_DAMAGE);
+	}
+	for (i = 0; i < chests_count; i++) {
+		chests[i].x = rand() % FIELD_SIZE;
+		chests[i].y = rand() % FIELD_SIZE;
+		fprintf(f, "%lu | chest | %lu | interactive_object | (%d,%d) | 0 | 0\n",
+				mobs_count + i + 1, 100 + mobs_count + i, chests[i].x, chests[i].y);
+	}
+	fprintf(f, "---\n");
+
+	for (t = 1; t <= steps && alive; t++) {
+		player.x = step(player.x);
+		player.y = step(player.y);
+		fprintf(f, "[%ld] Player (%d,%d)", t, player.x, player.y);
+		for (i = 0; i < mobs_count; i++) {
+			if (!mobs[i].alive) continue;
+			mobs[i].x = step(mobs[i].x);
+			mobs[i].y = step(mobs[i].y);
+			fprintf(f, "; %lu position: (%d,%d)", i + 1, mobs[i].x, mobs[i].y);
+		}
+		fprintf(f, "\n");
+
+		/* the player hits a random mob from time to time and finishes
+		   the mobs in the last tenth of the session */
+		if (rand() % 8 == 0 || t > steps - steps / 10) {
+			i = rand() % mobs_count;
+			if (!mobs[i].alive) continue;
+			mobs[i].hp -= HIT_DAMAGE;
+			t++;
+			fprintf(f, "[%ld] attack Player hits %d damage to %lu\n", t, HIT_DAMAGE, i + 1);
+			t++;
+			fprintf(f, "[%ld] attacked %lu for %d damage, current health: %d (%d%%)\n",
+					t, i + 1, HIT_DAMAGE, mobs[i].hp > 0 ? mobs[i].hp : 0,
+					mobs[i].hp > 0 ? mobs[i].hp * 100 / BASE_HP : 0);
+			if (mobs[i].hp <= 0) {
+				t++;
+				fprintf(f, "[%ld] Node was removed: %lu\n", t, i + 1);
+				mobs[i].alive = 0;
+				alive--;
+			}
+		}
+	}
+	if (!alive) {
+		fprintf(f, "[%ld] Game Over: Win\n", t++);
+	}
+	fprintf(f, "[%ld] Session ended\n", t);
+
+	fclose(f);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char* dir = NULL;
+	char path[MAX_PATH_LEN];
+	long logs = DEFAULT_LOGS, steps = DEFAULT_STEPS, i;
+	FILE* f;
+
+	if (argc < 2 || argc > 4) {
+		print_usage(argv[0]);
+		return 99;
+	}
+
+	dir = argv[1];
+	if (argc > 2) {
+		logs = atol(argv[2]);
+	}
+	if (argc > 3) {
+		steps = atol(argv[3]);
+	}
+	if (logs <= 0 || steps <= 0) {
+		print_usage(argv[0]);
+		return 99;
+	}
+
+	snprintf(path, MAX_PATH_LEN, "%s/%s", dir, BENCH_TASK_FILE);
+	f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "Cannot open task file %s\n", path);
+		return 1;
+	}
+	fputs(BENCH_TASK_CSV, f);
+	fclose(f);
+
+	snprintf(path, MAX_PATH_LEN, "%s/%s", dir, BENCH_CONFIG_FILE);
+	f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "Cannot open config file %s\n", path);
+		return 1;
+	}
+	fprintf(f, "secret:%s\n%s:%s/%s\n", BENCH_TASK_ID, BENCH_TASK_ID, dir, BENCH_TASK_FILE);
+	fclose(f);
+
+	/* the corpus is the same for the same arguments */
+	srand(1);
+	for (i = 0; i < logs; i++) {
+		snprintf(path, MAX_PATH_LEN, "%s/%04ld.log", dir, i);
+		if (generate_log(path, steps) != 0) {
+			return 1;
+		}
+	}
+
+	printf("Generated %ld logs for the task %s in %s\n", logs, BENCH_TASK_ID, dir);
+
+	return 0;
+}
@@ -21,13 +21,18 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ursulalogcheck.h"
 
+#define DETECT_TASK_ID "-"
+
 static void print_usage(const char* name)
 {
 	fprintf(stderr, "Usage: %s <config-file> <task-id> <salt> <log-file>\n", name);
 	fprintf(stderr, "\n");
+	fprintf(stderr, "Use '%s' as <task-id> to detect the task by the log scene.\n", DETECT_TASK_ID);
+	fprintf(stderr, "\n");
 }
 
 int main(int argc, char** argv)
@@ -55,6 +60,29 @@ int main(int argc, char** argv)
 		return res;
 	}
 
+	if (strcmp(task_id, DETECT_TASK_ID) == 0) {
+		const char** task_ids = NULL;
+		size_t tasks_count = 0, i;
+		res = cyberiada_ursula_log_checker_detect_tasks(checker, log_file, &task_ids, &tasks_count);
+		if (res != URSULA_CHECK_NO_ERROR) {
+			fprintf(stderr, "Task detection error: %d\n", res);
+			cyberiada_ursula_log_checker_free(checker);
+			return res;
+		}
+		printf("Candidate tasks: %lu\n", tasks_count);
+		for (i = 0; i < tasks_count; i++) {
+			printf("Candidate task: %s\n", task_ids[i]);
+		}
+		if (!tasks_count) {
+			free(task_ids);
+			cyberiada_ursula_log_checker_free(checker);
+			return URSULA_CHECK_BAD_PARAMETERS;
+		}
+		/* check the first candidate */
+		task_id = task_ids[0];
+		free(task_ids);
+	}
+
 	res = cyberiada_ursula_log_checker_check_log(checker,
 												 task_id,
 												 salt,
@@ -24,6 +24,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 #include "ursulalogcheck.h"
 #include "sha256.h"
@@ -50,6 +57,12 @@
 #define MAX_OBJECTS        20
 #define MAX_STR_LEN        4096
 #define DELTA              0.001
+#define PERF_COUNTERS      4
+#define MAX_SESSION_LINE_LEN (MAX_STR_LEN * 16)
+#define SESSION_LINE_CHUNK 128
+#define SESSION_LOG_NAME   "<session>"
+#define LOG_BUFFER_NAME    "<buffer>"
+#define TASKS_CHUNK        16
 
 /* -----------------------------------------------------------------------------
  * The base constants
@@ -161,7 +174,7 @@ typedef struct {
 	char*         class;                       /* object class name */
 	unsigned char minimum;                     /* the minimum number of objects on the scene */
 	unsigned char limit;                       /* the limit of objects on the scene */
-	unsigned char found;                       /* objects found in the scene */
+	unsigned long class_hash;                  /* object class name hash (the scene index) */
 } ObjectReq;
 
 typedef struct {
@@ -173,7 +186,7 @@ typedef struct {
 	float         hp;                          /* object hp */
 	float         damage;                      /* object damage */
 	char          pos_predefined;              /* object position was predefined in the config file */
-	char          valid;                       /* the object was checked */
+	unsigned long class_hash;                  /* object class name hash (the scene index) */
 } Object;
 
 typedef enum {
@@ -206,14 +219,41 @@ typedef struct _UrsulaCheckerTask {
 	size_t                     object_reqs_count; /* the number of object requirements */	
 	Condition*                 conditions;     /* the array of conditions */
 	size_t                     conditions_count; /* the number of the tasks's conditions */
+	unsigned int               scene_types;    /* the mask of the object types required in the scene */
 	struct _UrsulaCheckerTask* next;
 } UrsulaCheckerTask;
 
 struct _UrsulaLogCheckerData {
-	char*              secret;                 /* the global secret */
-	UrsulaCheckerTask* tasks;                  /* the tasks from the config file */
+	char*                 secret;              /* the global secret */
+	UrsulaCheckerTask*    tasks;               /* the tasks from the config file */
+	int                   stats_flags;         /* the statistics collection flags */
+	int                   perf_fds[PERF_COUNTERS]; /* the perf events (the first one is the group leader) */
+	UrsulaLogCheckerStats stats;               /* the accumulated statistics */
+};
+
+struct _UrsulaLogSession {
+	UrsulaLogCheckerData* checker;             /* the checker (the secret) */
+	UrsulaCheckerTask*    task;                /* the task plan and the scene index shared between sessions */
+	char                  state;               /* the log state: 'p', 's', 'o' - scene, 'l' - events, 'e' - ended, 'x' - error */
+	char                  first_pos;           /* the first position event was read */
+	Point                 player_pos;          /* the player start position */
+	Object*               objects;             /* the actual objects */
+	size_t                objects_count;       /* the actual objects count */
+	size_t                objects_capacity;    /* the allocated objects count */
+	unsigned char**       cond_matrix;         /* the satisfied conditions (the rows, the matrix and the frontier in one block) */
+	unsigned char*        cond_frontier;       /* the highest satisfied condition number for each object */
+	size_t                cond_matrix_size;    /* the block size */
+	char*                 line;                /* the incomplete log line */
+	size_t                line_size;           /* the incomplete log line size */
+	size_t                line_capacity;       /* the line buffer size */
+	size_t                lines;               /* the number of the complete lines */
 };
 
+typedef struct {
+	int                        phase;          /* the current check phase (-1 - none) */
+	UrsulaLogCheckerPhaseStats start;          /* the values on the phase start */
+} PhaseMeter;
+
 /* -----------------------------------------------------------------------------
  * Math functions
  * ----------------------------------------------------------------------------- */
@@ -280,6 +320,217 @@ static int parse_coordinates(char* s, Point* pos)
 	return URSULA_CHECK_NO_ERROR;
 }
 
+/* -----------------------------------------------------------------------------
+ * The log scene functions
+ * ----------------------------------------------------------------------------- */
+
+static int parse_scene_object(char* s, Object* obj, size_t line, const char* log_file)
+{
+	/* 0    1      2           3      4          5    6      */
+	/* ID | Name | Object ID | Type | Position | HP | Damage */
+	int j;
+	float n = 0.0;
+#ifdef __SILENT__
+	(void)line;
+	(void)log_file;
+#endif
+	for (j = 0; j < 6; j++) {
+		char* d = strchr(s, SO_DELIMITER), *d2;
+		if (!d) {
+			ERROR("Bad string '%s' on the line %lu in the log file %s!\n", s, line, log_file);
+			return URSULA_CHECK_FORMAT_ERROR;
+		}
+		*d = 0;
+		while (s < d && (*s == ' ' || *s == '\t')) {
+			s++;
+		}
+		d2 = d - 1;
+		while (d2 > s && (*d2 == ' ' || *d2 == '\t')) {
+			*d2 = 0;
+			d2--;
+		}
+		/* DEBUG("token line-%lu j-%d '%s'\n", line, j, s); */
+		if (j == 0) {
+			if (*s) {
+				copy_string(&(obj->id), NULL, s);
+			} else {
+				ERROR("Bad object id '%s' on the line %lu in the log file %s!\n", s, line - 1, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
+			}
+		} else if (j == 1) {
+			if (*s) {
+				copy_string(&(obj->class), NULL, s);
+			} else {
+				ERROR("Bad object class '%s' on the line %lu in the log file %s!\n", s, line - 1, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
+			}
+		} else if (j == 2) {
+			/* skip node id */
+		} else if (j == 3) {
+			if (strcmp(s, LOG_MOB) == 0) {
+				obj->type = otMob;
+			} else if (strcmp(s, LOG_INT_OBJECT) == 0) {
+				obj->type = otIntObject;
+			} else {
+				obj->type = otStatic;
+			}							
+		} else if (j == 4) {
+			if (parse_coordinates(s, &(obj->pos)) != URSULA_CHECK_NO_ERROR) {
+				ERROR("Bad players coordinates %s in the log file %s.\n", s, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
+			}
+			obj->prev_pos.x = obj->pos.x;
+			obj->prev_pos.y = obj->pos.y;
+			obj->pos_predefined = 1;
+		} else if (j == 5) {
+			n = atof(s);
+			obj->hp = n;
+		}
+		s = d + 1;
+	}
+	
+	n = atof(s);
+	obj->damage = n;
+
+	return URSULA_CHECK_NO_ERROR;
+}
+
+static unsigned long class_hash(const char* s)
+{
+	unsigned long hash = 5381;
+	if (!s) {
+		return 0;
+	}
+	while (*s) {
+		hash = ((hash << 5) + hash) + (unsigned char)*s;
+		s++;
+	}
+	return hash;
+}
+
+static int base_object_matches(const Object* base, const Object* obj)
+{
+	char types = base->type == obj->type,
+		classes = ((obj->class && *(obj->class) &&
+					base->class && *(base->class) &&
+					strcmp(base->class, obj->class) == 0) ||
+				   !base->class || !*(base->class)),
+		positions = ((base->pos_predefined &&
+					  DIST(obj->pos, base->pos) <= DELTA) ||
+					 !base->pos_predefined),
+		hps = ((base->hp > 0 &&
+				base->hp == obj->hp) ||
+			   base->hp == 0),
+		damages = (((base->damage > 0 &&
+					 base->damage == obj->damage) ||
+					base->damage == 0));
+	
+	/*DEBUG("compare types: %d classes: %d pos: %d hps: %d dmg: %d\n",
+	  types, classes, positions, hps, damages);*/
+	return types && classes && positions && hps && damages;
+}
+
+/* Process the line of the log header or the scene table in the single pass.
+   The state changes 'p' (player position) -> 's' (scene header) -> 'o' (scene
+   objects) -> 'l' (log events); the player object is added at the end of the table */
+static int scene_process_line(char* state,
+							  Point* player_pos,
+							  Object** objects,
+							  size_t* objects_count,
+							  size_t* objects_capacity,
+							  char* buffer,
+							  size_t line,
+							  const char* log_file)
+{
+	if (*state == 'p') {
+		if (strstr(buffer, LOG_PLAYER_START_POSITION) == buffer) {
+			char* s = buffer + strlen(LOG_PLAYER_START_POSITION);
+			if (parse_coordinates(s, player_pos) != URSULA_CHECK_NO_ERROR) {
+				ERROR("Bad players coordinates %s in the log file %s.\n", s, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
+			}
+			*state = 's';
+		}
+	} else if (*state == 's') {
+		if (strstr(buffer, LOG_SCENE_OBJECT_HEADER) == buffer) {
+			*state = 'o';
+		}
+	} else if (*state == 'o') {
+		Object* obj;
+		if (*objects_count == *objects_capacity) {
+			*objects_capacity = *objects_capacity ? *objects_capacity * 2 : MAX_OBJECTS;
+			*objects = (Object*)realloc(*objects, sizeof(Object) * *objects_capacity);
+			memset(*objects + *objects_count, 0, sizeof(Object) * (*objects_capacity - *objects_count));
+		}
+		obj = *objects + *objects_count;
+		(*objects_count)++;
+		if (strstr(buffer, LOG_HLINE) == buffer) {
+			/* add player */
+			obj->type = otPlayer;
+			obj->pos.x = obj->prev_pos.x = player_pos->x;
+			obj->pos.y = obj->prev_pos.y = player_pos->y;
+			obj->pos_predefined = 1;
+			*state = 'l';
+		} else {
+			return parse_scene_object(buffer, obj, line, log_file);
+		}
+	}
+	return URSULA_CHECK_NO_ERROR;
+}
+
+/* Check the scene objects (with the class hashes calculated) against the task
+   base objects and object requirements without changing the task; the mismatch
+   is reported when the log file name is set */
+static int scene_matches_task(const UrsulaCheckerTask* task,
+							  const Object* objects,
+							  size_t objects_count,
+							  const char* log_file)
+{
+	size_t i, j;
+
+	for (i = 0; i < task->base_objects_count; i++) {
+		const Object* base = task->base_objects + i;
+		char found = 0;
+		for (j = 0; j < objects_count; j++) {
+			if ((!base->class || !*(base->class) || base->class_hash == objects[j].class_hash) &&
+				base_object_matches(base, objects + j)) {
+				found = 1;
+				break;
+			}
+		}
+		if (!found) {
+			if (log_file) {
+				ERROR("Log %s does not contain correct base object type %s class %s\n",
+					  log_file, OBJECT_TYPE_STR[base->type], base->class);
+			}
+			return 0;
+		}
+	}
+
+	for (i = 0; i < task->object_reqs_count; i++) {
+		const ObjectReq* objreq = task->object_reqs + i;
+		size_t found = 0;
+		for (j = 0; j < objects_count; j++) {
+			if (objreq->type == objects[j].type &&
+				objreq->class_hash == objects[j].class_hash &&
+				objreq->class && objects[j].class &&
+				strcmp(objreq->class, objects[j].class) == 0) {
+				found++;
+			}
+		}
+		if (found < objreq->minimum || found > objreq->limit) {
+			if (log_file) {
+				ERROR("Log %s does not contain object corresponding the obj. req. type %s class %s - %lu (min: %d max: %d)\n",
+					  log_file, OBJECT_TYPE_STR[objreq->type], objreq->class,
+					  found, objreq->minimum, objreq->limit);
+			}
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
 /* -----------------------------------------------------------------------------
  * The checker config functions
  * ----------------------------------------------------------------------------- */
@@ -337,24 +588,42 @@ static int cyberiada_ursula_log_destroy_tasks(UrsulaCheckerTask* task)
 	return URSULA_CHECK_NO_ERROR;
 }
 
-static int cyberiada_ursula_log_task_config(const char* cfgfile, UrsulaCheckerTask** _task, const char* name)
+/* Build the scene index of the task: the class hashes of the base objects and
+   the object requirements and the mask of the object types the scene should contain */
+static int cyberiada_ursula_log_index_task(UrsulaCheckerTask* task)
 {
-	FILE* cfg;
-	char* buffer = NULL;
-	size_t i, line = 0;
-	UrsulaCheckerTask* task = NULL;
-	size_t base_objects_cnt = 0, object_reqs_cnt = 0, conditions_cnt = 0;
-	int last_n = 0;
+	size_t i;
 
-	if (!cfgfile || !*cfgfile || !_task) {
+	if (!task) {
 		return URSULA_CHECK_BAD_PARAMETERS;
 	}
 
-	cfg = fopen(cfgfile, "r");
-	if (!cfg) {
-		ERROR("Cannot open config file %s\n", cfgfile);
-		return URSULA_CHECK_BAD_PARAMETERS;		
+	task->scene_types = 0;
+	for (i = 0; i < task->base_objects_count; i++) {
+		Object* obj = task->base_objects + i;
+		obj->class_hash = class_hash(obj->class);
+		task->scene_types |= 1 << obj->type;
 	}
+	for (i = 0; i < task->object_reqs_count; i++) {
+		ObjectReq* objreq = task->object_reqs + i;
+		objreq->class_hash = class_hash(objreq->class);
+		task->scene_types |= 1 << objreq->type;
+	}
+
+	return URSULA_CHECK_NO_ERROR;
+}
+
+/* Read the task config (CSV) from the opened file, the file is closed on exit */
+static int cyberiada_ursula_log_task_config_file(FILE* cfg, const char* cfgfile, UrsulaCheckerTask** _task, const char* name)
+{
+	char* buffer = NULL;
+	size_t i, line = 0;
+	UrsulaCheckerTask* task = NULL;
+	size_t base_objects_cnt = 0, object_reqs_cnt = 0, conditions_cnt = 0;
+	int last_n = 0;
+#ifdef __SILENT__
+	(void)cfgfile;
+#endif
 
 	buffer = (char*)malloc(sizeof(char) * MAX_STR_LEN);
 	task = cyberiada_ursula_log_new_task(name);
@@ -397,14 +666,14 @@ static int cyberiada_ursula_log_task_config(const char* cfgfile, UrsulaCheckerTa
 
 	if (!task->conditions_count) {
 		ERROR("No conditions described in the config file %s!\n", cfgfile);
-		free(task);
+		cyberiada_ursula_log_destroy_tasks(task);
 		free(buffer);
 		fclose(cfg);
 		return URSULA_CHECK_BAD_PARAMETERS;
 	}
 	if (task->conditions_count > MAX_CONDITIONS) {
 		ERROR("Too many conditions (%lu) described in the config file %s!\n", task->conditions_count, cfgfile);
-		free(task);
+		cyberiada_ursula_log_destroy_tasks(task);
 		free(buffer);
 		fclose(cfg);
 		return URSULA_CHECK_BAD_PARAMETERS;
@@ -484,12 +753,19 @@ static int cyberiada_ursula_log_task_config(const char* cfgfile, UrsulaCheckerTa
 							goto error_csv;
 						}
 						if (conditions_cnt > 0 && n == task->conditions[conditions_cnt - 1].n) {
+							if (task->conditions[conditions_cnt - 1].second_cond) {
+								ERROR("Too many operands of the condition %d in the config file %s!\n", n, cfgfile);
+								goto error_csv;
+							}
 							conditions_cnt--;
 							task->conditions[conditions_cnt].second_cond = (Condition*)malloc(sizeof(Condition));
-							task->conditions[conditions_cnt].second_cond->primary_obj_class = NULL;
-							task->conditions[conditions_cnt].second_cond->secondary_obj_class = NULL;
+							memset(task->conditions[conditions_cnt].second_cond, 0, sizeof(Condition));
 							task->conditions[conditions_cnt].second_cond->n = n;
 						} else {
+							if (conditions_cnt >= task->conditions_count) {
+								ERROR("Bad condition order on line %lu in the config file %s!\n", line, cfgfile);
+								goto error_csv;
+							}
 							task->conditions[conditions_cnt].n = n;
 							task->conditions[conditions_cnt].second_cond = NULL;
 						}
@@ -717,6 +993,23 @@ static int cyberiada_ursula_log_task_config(const char* cfgfile, UrsulaCheckerTa
 	return URSULA_CHECK_NO_ERROR;
 }
 
+static int cyberiada_ursula_log_task_config(const char* cfgfile, UrsulaCheckerTask** _task, const char* name)
+{
+	FILE* cfg;
+
+	if (!cfgfile || !*cfgfile || !_task) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	cfg = fopen(cfgfile, "r");
+	if (!cfg) {
+		ERROR("Cannot open config file %s\n", cfgfile);
+		return URSULA_CHECK_BAD_PARAMETERS;		
+	}
+
+	return cyberiada_ursula_log_task_config_file(cfg, cfgfile, _task, name);
+}
+
 static int cyberiada_ursula_log_print_condition(Condition* cond, const char* tab)
 {	
 	if (!cond) {
@@ -859,6 +1152,100 @@ static int cyberiada_ursula_log_print_task(UrsulaCheckerTask* task)
 	return URSULA_CHECK_NO_ERROR;	
 }
 
+/* -----------------------------------------------------------------------------
+ * The checker statistics functions
+ * ----------------------------------------------------------------------------- */
+
+static void cyberiada_ursula_log_close_counters(UrsulaLogCheckerData* checker)
+{
+	size_t i;
+	for (i = 0; i < PERF_COUNTERS; i++) {
+#ifdef __linux__
+		if (checker->perf_fds[i] >= 0) close(checker->perf_fds[i]);
+#endif
+		checker->perf_fds[i] = -1;
+	}
+}
+
+static int cyberiada_ursula_log_open_counters(UrsulaLogCheckerData* checker)
+{
+#ifdef __linux__
+	static const unsigned long long configs[PERF_COUNTERS] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	size_t i;
+
+	for (i = 0; i < PERF_COUNTERS; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.read_format = PERF_FORMAT_GROUP;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		checker->perf_fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1,
+											i == 0 ? -1 : checker->perf_fds[0], 0);
+		if (checker->perf_fds[i] < 0) {
+			ERROR("Cannot open the hardware performance counter %lu\n", i);
+			cyberiada_ursula_log_close_counters(checker);
+			return URSULA_CHECK_NOT_SUPPORTED;
+		}
+	}
+	return URSULA_CHECK_NO_ERROR;
+#else
+	(void)checker;
+	return URSULA_CHECK_NOT_SUPPORTED;
+#endif
+}
+
+static void stats_snapshot(UrsulaLogCheckerData* checker, UrsulaLogCheckerPhaseStats* snapshot)
+{
+	memset(snapshot, 0, sizeof(UrsulaLogCheckerPhaseStats));
+	if (checker->stats_flags & URSULA_CHECK_STATS_TIME) {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		snapshot->time_ns = (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+#ifdef __linux__
+	if (checker->stats_flags & URSULA_CHECK_STATS_COUNTERS) {
+		/* PERF_FORMAT_GROUP layout: nr, values[nr] */
+		unsigned long long values[PERF_COUNTERS + 1];
+		if (read(checker->perf_fds[0], values, sizeof(values)) == (ssize_t)sizeof(values)) {
+			snapshot->cycles = values[1];
+			snapshot->instructions = values[2];
+			snapshot->cache_misses = values[3];
+			snapshot->branch_misses = values[4];
+		}
+	}
+#endif
+}
+
+/* Finish the current check phase (if any) and start the new one (-1 - none) */
+static void stats_switch_phase(UrsulaLogCheckerData* checker, PhaseMeter* meter, int phase)
+{
+	UrsulaLogCheckerPhaseStats now;
+	
+	if (!checker || !checker->stats_flags) {
+		return;
+	}
+
+	stats_snapshot(checker, &now);
+	if (meter->phase >= 0) {
+		UrsulaLogCheckerPhaseStats* acc = checker->stats.phases + meter->phase;
+		acc->time_ns += now.time_ns - meter->start.time_ns;
+		acc->cycles += now.cycles - meter->start.cycles;
+		acc->instructions += now.instructions - meter->start.instructions;
+		acc->cache_misses += now.cache_misses - meter->start.cache_misses;
+		acc->branch_misses += now.branch_misses - meter->start.branch_misses;
+	}
+	meter->start = now;
+	meter->phase = phase;
+}
+
 /* -----------------------------------------------------------------------------
  * The checker library functions
  * ----------------------------------------------------------------------------- */
@@ -884,6 +1271,9 @@ int cyberiada_ursula_log_checker_init(UrsulaLogCheckerData** checker, const char
 	buffer = (char*)malloc(sizeof(char) * MAX_STR_LEN);
 	*checker = (UrsulaLogCheckerData*)malloc(sizeof(UrsulaLogCheckerData));
 	memset(*checker, 0, sizeof(UrsulaLogCheckerData));
+	for (i = 0; i < PERF_COUNTERS; i++) {
+		(*checker)->perf_fds[i] = -1;
+	}
 	
 	while(!feof(cfg)) {
 		size_t size = MAX_STR_LEN - 1;
@@ -916,6 +1306,9 @@ int cyberiada_ursula_log_checker_init(UrsulaLogCheckerData** checker, const char
 			} else {
 				UrsulaCheckerTask* task = NULL;
 				res = cyberiada_ursula_log_task_config(csvfile, &task, buffer);
+				if (res == URSULA_CHECK_NO_ERROR) {
+					res = cyberiada_ursula_log_index_task(task);
+				}
 				if (res != URSULA_CHECK_NO_ERROR) {
 					cyberiada_ursula_log_destroy_tasks(task);
 					cyberiada_ursula_log_checker_free(*checker);
@@ -963,6 +1356,8 @@ int cyberiada_ursula_log_checker_free(UrsulaLogCheckerData* checker)
 		cyberiada_ursula_log_destroy_tasks(checker->tasks);
 	}
 
+	cyberiada_ursula_log_close_counters(checker);
+
 	free(checker);
 	
 	return URSULA_CHECK_NO_ERROR;
@@ -983,6 +1378,46 @@ static char* generate_code(const char* secret, const char* task_name, int salt,
 	return result_code;
 }
 
+/* The condition frontier keeps the highest satisfied condition number for each
+   object (0 - none). The object can not approve the condition with the index
+   below the frontier, so there is no need to evaluate such conditions for it. */
+static int object_condition_passed(const unsigned char* cond_frontier, size_t obj_index, size_t cond_index)
+{
+	return cond_frontier && cond_frontier[obj_index] > cond_index;
+}
+
+/* The number of the first objects to scan for the multi-object condition: the
+   first matching object gets the condition, so the scan stops after the last
+   object that can still approve it (0 - all candidates are blocked) */
+static size_t condition_candidates(const unsigned char* cond_frontier, size_t objects_count,
+								   size_t primary_index, size_t cond_index)
+{
+	size_t i = objects_count;
+	if (!cond_frontier) {
+		return objects_count;
+	}
+	if (primary_index < objects_count) {
+		return object_condition_passed(cond_frontier, primary_index, cond_index) ? 0 : objects_count;
+	}
+	while (i > 0 && object_condition_passed(cond_frontier, i - 1, cond_index)) {
+		i--;
+	}
+	return i;
+}
+
+/* The evaluation of the condition fixes the objects for the further conditions
+   of the same type, so only the last condition of the type can be pruned */
+static int condition_last_of_type(UrsulaCheckerTask* task, size_t cond_index)
+{
+	size_t i;
+	for (i = cond_index + 1; i < task->conditions_count; i++) {
+		if (task->conditions[i].type == task->conditions[cond_index].type) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
 static int cyberiada_test_condition(unsigned int time,
 									Condition* cond,
 									Object* objects,
@@ -992,10 +1427,12 @@ static int cyberiada_test_condition(unsigned int time,
 									Object* secondary,
 									size_t* secondary_index,
 									float argument,
-									char won)
+									char won,
+									const unsigned char* cond_frontier,
+									size_t cond_index)
 {
 	char found = 0;
-	size_t i, j;
+	size_t i, j, candidates = objects_count;
 	size_t objects_found[MAX_OBJECTS];
 	char multiple_objects;
 	
@@ -1018,12 +1455,16 @@ static int cyberiada_test_condition(unsigned int time,
 		for (i = 0; i < objects_count; i++) {
 			objects_found[i] = objects_count;
 		}
+		candidates = condition_candidates(cond_frontier, objects_count, *primary_index, cond_index);
+		if (!candidates) {
+			return 0;
+		}
 	} else {
 		multiple_objects = 0;
 	}
 
 	if (cond->type == condObjectMoving) {
-		for (i = 0; i < objects_count; i++) {
+		for (i = 0; i < candidates && !found; i++) {
 			primary = objects + i;
 			if (*primary_index < objects_count && *primary_index != i) {
 				continue;
@@ -1039,11 +1480,12 @@ static int cyberiada_test_condition(unsigned int time,
 #endif
 				if (dist > 0) {
 					objects_found[i] = i;
+					found = 1;
 				}
 			}
 		}
 	} else if (cond->type == condObjectProximity) {
-		for (i = 0; i < objects_count; i++) {
+		for (i = 0; i < candidates && !found; i++) {
 			primary = objects + i;
 			if (*primary_index < objects_count && *primary_index != i) {
 				continue;
@@ -1074,13 +1516,14 @@ static int cyberiada_test_condition(unsigned int time,
 #endif
 					if (dist <= cond->argument) {
 						objects_found[i] = j;
+						found = 1;
 						break;
 					}
 				}
 			}
 		}
 	} else if (cond->type == condObjectApproaching) {
-		for (i = 0; i < objects_count; i++) {
+		for (i = 0; i < candidates && !found; i++) {
 			primary = objects + i;
 			if (*primary_index < objects_count && *primary_index != i) {
 				continue;
@@ -1113,13 +1556,14 @@ static int cyberiada_test_condition(unsigned int time,
 #endif
 					if (moving && dist < prev_dist) {
 						objects_found[i] = j;
+						found = 1;
 						break;
 					}
 				}
 			}
 		}	
 	} else if (cond->type == condObjectRetiring) {
-		for (i = 0; i < objects_count; i++) {
+		for (i = 0; i < candidates && !found; i++) {
 			primary = objects + i;
 			if (*primary_index < objects_count && *primary_index != i) {
 				continue;
@@ -1152,6 +1596,7 @@ static int cyberiada_test_condition(unsigned int time,
 #endif
 					if (moving && dist > prev_dist) {
 						objects_found[i] = j;
+						found = 1;
 						break;
 					}
 				}
@@ -1233,10 +1678,10 @@ static int cyberiada_test_condition(unsigned int time,
 						strcmp(cond->primary_obj_class, cond->second_cond->primary_obj_class) == 0) {
 
 						found = cyberiada_test_condition(time, cond->second_cond, objects, objects_count,
-														 NULL, primary_index, NULL, secondary_index, 0, 0);
+														 NULL, primary_index, NULL, secondary_index, 0, 0, NULL, 0);
 					} else {
 						found = cyberiada_test_condition(time, cond->second_cond, objects, objects_count,
-														 NULL, secondary_index, NULL, primary_index, 0, 0);
+														 NULL, secondary_index, NULL, primary_index, 0, 0, NULL, 0);
 					}
 				} 
 			}
@@ -1260,7 +1705,7 @@ static int cyberiada_test_condition(unsigned int time,
 				cyberiada_ursula_log_print_condition(cond->second_cond, "");
 #endif
 				return cyberiada_test_condition(time, cond->second_cond, objects, objects_count, NULL,
-												primary_index, NULL, secondary_index, 0, 0);
+												primary_index, NULL, secondary_index, 0, 0, NULL, 0);
 			}
 			return 1;
 		}
@@ -1274,13 +1719,14 @@ static int cyberiada_test_the_condition(ConditionType type,
 										Object* objects,
 										size_t objects_count,
 										unsigned char** cond_matrix,
+										unsigned char* cond_frontier,
 										Object* primary,
 										size_t primary_index,
 										Object* secondary,
 										float argument,
 										char won)
 {
-	size_t i, j;
+	size_t i;
 	size_t secondary_index = objects_count;
 
 #ifdef FULL_LOGS
@@ -1289,39 +1735,33 @@ static int cyberiada_test_the_condition(ConditionType type,
 
 	for (i = 0; i < task->conditions_count; i++) {
 		Condition* cond = task->conditions + i;
+		char prune;
 		if (cond->type != type) continue;
+		prune = cond->type != condGameWon && condition_last_of_type(task, i);
+		if (prune && primary_index < objects_count &&
+			object_condition_passed(cond_frontier, primary_index, i)) {
+			/* the object has already satisfied this or the further condition */
+			continue;
+		}
 		if (cyberiada_test_condition(time, cond, objects, objects_count,
-									 primary, &primary_index, secondary, &secondary_index, argument, won)) {
+									 primary, &primary_index, secondary, &secondary_index, argument, won,
+									 prune ? cond_frontier : NULL, i)) {
 			if (cond->type == condGameWon) {
 				size_t obj_index;
 				for (obj_index = 0; obj_index < objects_count; obj_index++) {
-					char found = 0;
-					size_t j;
-					for (j = i + 1; j < task->conditions_count; j++) {
-						if (cond_matrix[j][obj_index]) {
-							found = 1;
-							break;
-						}
-					}
-					if (!found) {
+					if (!object_condition_passed(cond_frontier, obj_index, i + 1)) {
 						cond_matrix[i][obj_index] = 1;
+						cond_frontier[obj_index] = i + 1;
 					}
 				}
 			} else {
-				char found = 0;
 				if (primary_index == objects_count) {
 #ifdef FULL_LOGS
 					DEBUG("Object primary index doesn't found!\n");
 #endif
 					return 0;
 				}				
-				for (j = i + 1; j < task->conditions_count; j++) {
-					if (cond_matrix[j][primary_index]) {
-						found = 1;
-						break;
-					}
-				}
-				if (!found && !cond_matrix[i][primary_index]) {
+				if (!object_condition_passed(cond_frontier, primary_index, i)) {
 					DEBUG("Approve condition %lu for object %s (%s, %s) on time %u\n",
 						  i + 1,
 						  objects[primary_index].type != otPlayer ? objects[primary_index].id : "PL",
@@ -1329,6 +1769,7 @@ static int cyberiada_test_the_condition(ConditionType type,
 						  objects[primary_index].type != otPlayer ? objects[primary_index].class : "",
 						  time);
 					cond_matrix[i][primary_index] = 1;
+					cond_frontier[primary_index] = i + 1;
 				}
 			}
 		}
@@ -1341,6 +1782,7 @@ static int cyberiada_test_all_conditions(unsigned int time,
 										 Object* objects,
 										 size_t objects_count,
 										 unsigned char** cond_matrix,
+										 unsigned char* cond_frontier,
 										 Object* primary,
 										 size_t primary_index,
 										 Object* secondary,
@@ -1350,548 +1792,397 @@ static int cyberiada_test_all_conditions(unsigned int time,
 	size_t i;
 	for (i = 0; i < task->conditions_count; i++) {
 		cyberiada_test_the_condition(task->conditions[i].type,
-									 time, task, objects, objects_count, cond_matrix,
+									 time, task, objects, objects_count, cond_matrix, cond_frontier,
 									 primary, primary_index, secondary, argument, won);
 	}
 	return 0;
 }
 
-/* Check the CyberiadaML program from the buffer in the context of the task */
-int cyberiada_ursula_log_checker_check_log(UrsulaLogCheckerData* checker,
-										   const char* task_name,
-										   int salt,
-										   const char* log_file,
-										   UrsulaLogCheckerResult* result,
-										   char** result_code)
+/* Process the log event line (the line after the scene table) */
+static int cyberiada_ursula_log_process_event(UrsulaLogCheckerData* checker,
+											  PhaseMeter* meter,
+											  UrsulaCheckerTask* task,
+											  Object* objects,
+											  size_t objects_count,
+											  unsigned char** cond_matrix,
+											  unsigned char* cond_frontier,
+											  char* first_pos,
+											  char* buffer,
+											  const char* log_file,
+											  char* ended)
 {
-	UrsulaLogCheckerResult res = URSULA_CHECK_RESULT_ERROR;
-	UrsulaCheckerTask*     task;
-	Object*                objects = NULL;             /* the actual objects */
-	size_t                 objects_count = 0;          /* the actual objects count */
-	unsigned char**        cond_matrix = NULL;         /* the matrix of satisfied conditions (objects x conditions) */
-	size_t i, line = 0;
-	char* buffer = NULL;
-	FILE* log = NULL;
-	char state = 'p';
-	Point player_pos = {0.0, 0.0};
-	char first_pos = 0;
-
-	if (!checker || !task_name || !log_file) {
-		ERROR("Bad check program arguments!\n");
-		if (result) {
-			*result = URSULA_CHECK_RESULT_ERROR;
-		}
-		return URSULA_CHECK_BAD_PARAMETERS;
-	}
-
-	task = checker->tasks;
-	while (task) {
-		if (strcmp(task->name, task_name) == 0) {
-			/* found! */
-			break;
-		}
-		task = task->next;
+	size_t i;
+	char* s = buffer, *d;
+	unsigned int time = 0;
+#ifdef __SILENT__
+	(void)log_file;
+#endif
+	if (*s != TIME_START_CHAR) {
+		return URSULA_CHECK_NO_ERROR;
 	}
-	if (!task) {
-		ERROR("Cannot find task with name %s\n", task_name);
-		if (result) {
-			*result = URSULA_CHECK_RESULT_ERROR;
-		}
-		return URSULA_CHECK_BAD_PARAMETERS;
+	s++;
+	d = strchr(s, TIME_FINISH_CHAR);
+	if (!d) {
+		ERROR("Bad log string '%s' format (no time section) in the log file %s.\n", s, log_file);
+		return URSULA_CHECK_FORMAT_ERROR;
 	}
+	*d = 0;
+	time = atoi(s);
+	s = d + 1;
+	while(*s && (*s == ' ' || *s == '\t')) s++;
+	if (strstr(s, LOG_POSITION) != NULL) {
+		while(*s) {
+			Object* pos_object = NULL;
+			char *d, *d2, *next;
+			char player_pos = 0;
+			
+			while(*s && (*s == ' '  || *s == '\t')) s++;
+			d = strchr(s, POSITION_LOG_DELIMITER);
+			if (!d) {
+				d = s + strlen(s);
+				next = d;
+			} else {
+				*d = 0;
+				next = d + 1;
+			}
 
-	log = fopen(log_file, "r");
-	if (!log) {
-		ERROR("Cannot open log file %s\n", log_file);
-		if (result) {
-			*result = URSULA_CHECK_RESULT_ERROR;
-		}
-		return URSULA_CHECK_BAD_PARAMETERS;		
-	}
-	
-	for (i = 0; i < task->base_objects_count; i++) {
-		task->base_objects[i].valid = 0;
-	}
-	for (i = 0; i < task->object_reqs_count; i++) {
-		task->object_reqs[i].found = 0;
-	}
-
-	DEBUG("Checking task:\n");
-	cyberiada_ursula_log_print_task(task);
-	
-	buffer = (char*)malloc(sizeof(char) * MAX_STR_LEN);
-
-	while(!feof(log)) {
-		line++;
-		size_t size = MAX_STR_LEN - 1;
-		ssize_t strsize = getline(&buffer, &size, log);
-		if (strsize <= 0) {
-			continue;
-		}
-
-		if (buffer[strsize - 1] == '\n') {
-			buffer[strsize - 1] = 0;
-		}
-
-		if (state == 'p') {
-			if (strstr(buffer, LOG_PLAYER_START_POSITION) == buffer) {
-				char* s = buffer + strlen(LOG_PLAYER_START_POSITION);
-				if (parse_coordinates(s, &player_pos) != URSULA_CHECK_NO_ERROR) {
-					ERROR("Bad players coordinates %s in the log file %s.\n", s, log_file);
-					goto error_log;
-				}
-				state = 's';
+			d2 = strchr(s, ATTACK_LOG_DELIMITER);
+			if (!d2) {
+				ERROR("Bad position string '%s' on time %u in the log file %s.\n", s, time, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
 			}
-		} else if (state == 's') {
-			if (strstr(buffer, LOG_SCENE_OBJECT_HEADER) == buffer) {
-				state = 'o';
-			}
-		} else if (state == 'o') {
-			if (!objects) {
-				objects_count++;
-				if (strstr(buffer, LOG_HLINE) == buffer) {
-					state = 's';
-					if (objects_count == 0) {
-						fclose(log);
-						free(buffer);
-						ERROR("No objects in log\n");
-						if (result) {
-							*result = URSULA_CHECK_RESULT_ERROR;
-						}
-						return URSULA_CHECK_BAD_PARAMETERS;		
+			*d2 = 0;
+
+			if (strstr(s, LOG_PLAYER) == s) {
+				player_pos = 1;
+				for (i = 0; i < objects_count; i++) {
+					if (objects[i].type == otPlayer) {
+						pos_object = objects + i; 
+						break;
 					}
-					/* add player object */
-					objects = (Object*)malloc(sizeof(Object) * objects_count); /* reserve for players */
-					memset(objects, 0, sizeof(Object) * objects_count);
-					i = 0;
-					line = 0;
-					fseek(log, 0, SEEK_SET); /* looking from the beginning */
 				}
 			} else {
-				if (strstr(buffer, LOG_HLINE) == buffer) {
-					int found = -1;
-					
-					if (i != objects_count - 1) {
-						ERROR("Wrong number of objects %lu instead of %lu in the log file %s.\n",
-							  i, objects_count - 1, log_file);
-						goto error_log;
-					}
-					/* add player */
-					objects[i].type = otPlayer;
-					objects[i].class = NULL;
-					objects[i].id = NULL;
-					objects[i].pos.x = objects[i].prev_pos.x = player_pos.x;
-					objects[i].pos.y = objects[i].prev_pos.x = player_pos.y;
-					objects[i].hp = 0.0;
-					objects[i].damage = 0.0;
-					objects[i].pos_predefined = 1;
-
-					DEBUG("Log objects:\n");
-					for (i = 0; i < objects_count; i++) {
-						print_object(objects + i, i + 1, "\t");
-					}
-					
-					/* check objects */
-
-					for (i = 0; i < objects_count; i++) {
-						size_t j;
-						for (j = 0; j < task->base_objects_count; j++) {
-							char types = task->base_objects[j].type == objects[i].type,
-								classes = ((objects[i].class && *(objects[i].class) &&
-											task->base_objects[j].class && *(task->base_objects[j].class) &&
-											strcmp(task->base_objects[j].class, objects[i].class) == 0) ||
-										   !task->base_objects[j].class || !*(task->base_objects[j].class)),
-								positions = ((task->base_objects[j].pos_predefined &&
-											  DIST(objects[i].pos, task->base_objects[j].pos) <= DELTA) ||
-											 !task->base_objects[j].pos_predefined),
-								hps = ((task->base_objects[j].hp > 0 &&
-										task->base_objects[j].hp == objects[i].hp) ||
-									   task->base_objects[j].hp == 0),
-								damages = (((task->base_objects[j].damage > 0 &&
-											 task->base_objects[j].damage == objects[i].damage) ||
-											task->base_objects[j].damage == 0));
-							
-							/*DEBUG("compare i %lu and j %lu types: %d classes: %d pos: %d hps: %d dmg: %d valid: %d\n",
-							  i, j, types, classes, positions, hps, damages, task->base_objects[j].valid);*/
-							if (types && classes && positions && hps && damages && !task->base_objects[j].valid) {
-								task->base_objects[j].valid = 1;
-							}
-						}
-						for (j = 0; j < task->object_reqs_count; j++) {
-							if (task->object_reqs[j].type == objects[i].type &&
-								strcmp(task->object_reqs[j].class, objects[i].class) == 0) {
-
-								task->object_reqs[j].found++;
-								/* DEBUG("Found %s %s object\n", */
-								/* 	  OBJECT_TYPE_STR[task->object_reqs[j].type], */
-								/* 	  task->object_reqs[j].class); */
-							}
-						}
-					}
-
-					found = -1;
-					for (i = 0; i < task->base_objects_count; i++) {
-						if (!task->base_objects[i].valid) {
-							found = i;
-							break;
-						}
-					}
-					if (found >= 0) {
-						ERROR("Log does not contain correct base object type %s class %s\n",
-							  OBJECT_TYPE_STR[task->base_objects[found].type],
-							  task->base_objects[found].class);
-						goto error_log;
-					}
-					
-					for (i = 0; i < task->object_reqs_count; i++) {
-						if (task->object_reqs[i].found < task->object_reqs[i].minimum ||
-							task->object_reqs[i].found > task->object_reqs[i].limit) {
-							found = i;
-							break;
-						}
-					}
-					if (found >= 0) {
-						ERROR("Log does not contain object corresponding the obj. req. type %s class %s - %d (min: %d max: %d)\n",
-							  OBJECT_TYPE_STR[task->object_reqs[found].type],
-							  task->object_reqs[found].class,
-							  task->object_reqs[found].found,
-							  task->object_reqs[found].minimum,
-							  task->object_reqs[found].limit);
-						goto error_log;
+				for (i = 0; i < objects_count; i++) {
+					if (objects[i].type != otPlayer && strcmp(s, objects[i].id) == 0) {
+						pos_object = objects + i;
+						break;
 					}
+				}
+			}
+			if (!pos_object) {
+				ERROR("Unknown object %s in position string on time %u in the log file %s.\n", s, time, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
+			}
+			s = d2 + 1;
 
-					cond_matrix = (unsigned char**)malloc(sizeof(unsigned char*) * MAX_CONDITIONS);
-					for (i = 0; i < MAX_CONDITIONS; i++) {
-						cond_matrix[i] = (unsigned char*)malloc(sizeof(unsigned char) * objects_count);
-						memset(cond_matrix[i], 0, sizeof(unsigned char) * objects_count);
-					}
-					
-					state = 'l';
-				} else {				
-					/* parse objects */
-					/* 0    1      2           3      4          5    6      */
-					/* ID | Name | Object ID | Type | Position | HP | Damage */
-					int j;
-					char* s = buffer;
-					float n = 0.0;
-					for (j = 0; j < 6; j++) {
-						char* d = strchr(s, SO_DELIMITER), *d2;
-						if (!d) {
-							ERROR("Bad string '%s' on the line %lu in the log file %s!\n", s, line, log_file);
-							goto error_log;
-						}
-						*d = 0;
-						while (s < d && (*s == ' ' || *s == '\t')) {
-							s++;
-						}
-						d2 = d - 1;
-						while (d2 > s && (*d2 == ' ' || *d2 == '\t')) {
-							*d2 = 0;
-							d2--;
-						}
-						/* DEBUG("token line-%lu j-%d '%s'\n", line, j, s); */
-						if (j == 0) {
-							if (*s) {
-								copy_string(&(objects[i].id), NULL, s);
-							} else {
-								ERROR("Bad object id '%s' on the line %lu in the log file %s!\n", s, line - 1, log_file);
-								goto error_log;
-							}
-						} else if (j == 1) {
-							if (*s) {
-								copy_string(&(objects[i].class), NULL, s);
-							} else {
-								ERROR("Bad object class '%s' on the line %lu in the log file %s!\n", s, line - 1, log_file);
-								goto error_log;
-							}
-						} else if (j == 2) {
-							/* skip node id */
-						} else if (j == 3) {
-							if (strcmp(s, LOG_MOB) == 0) {
-								objects[i].type = otMob;
-							} else if (strcmp(s, LOG_INT_OBJECT) == 0) {
-								objects[i].type = otIntObject;
-							} else {
-								objects[i].type = otStatic;
-							}							
-						} else if (j == 4) {
-							if (parse_coordinates(s, &(objects[i].pos)) != URSULA_CHECK_NO_ERROR) {
-								ERROR("Bad players coordinates %s in the log file %s.\n", s, log_file);
-								goto error_log;
-							}
-							objects[i].prev_pos.x = objects[i].pos.x;
-							objects[i].prev_pos.y = objects[i].pos.y;;
-							objects[i].pos_predefined = 1;
-						} else if (j == 5) {
-							n = atof(s);
-							objects[i].hp = n;
-						}
-						s = d + 1;
-					}
-					
-					n = atof(s);
-					objects[i].damage = n;
+			pos_object->prev_pos.x = pos_object->pos.x;
+			pos_object->prev_pos.y = pos_object->pos.y;
 
-					i++;
+			if (!player_pos) {
+				/* skip "position:" */
+				d2 = strchr(s, ATTACK_LOG_DELIMITER);
+				if (!d2) {
+					ERROR("Bad position string '%s' on time %u in the log file %s.\n", s, time, log_file);
+					return URSULA_CHECK_FORMAT_ERROR;
 				}
+				s = d2 + 1;
 			}
-		} else if (state == 'l') {
-			char* s = buffer, *d;
-			unsigned int time = 0;
-			if (*s != TIME_START_CHAR) {
-				continue;
+				
+			if (parse_coordinates(s, &(pos_object->pos)) != URSULA_CHECK_NO_ERROR) {
+				ERROR("Bad coordinates %s in position string on time %u in the log file %s.\n", s, time, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
 			}
-			s++;
-			d = strchr(s, TIME_FINISH_CHAR);
+			
+			s = next;
+		}
+		
+		if (!*first_pos) {
+			*first_pos = 1;
+		} else {
+			stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVAL);
+			cyberiada_test_all_conditions(time, task, objects, objects_count, cond_matrix, cond_frontier, NULL, objects_count, NULL, 0.0, 0);
+			stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVENTS);
+		}
+	} else if (strstr(s, LOG_ATTACK) == s) {
+		size_t attacker_index = 0;
+		Object *attacker = NULL, *target = NULL;
+		float damage = 0;
+		char *d2;
+
+		s += strlen(LOG_ATTACK);
+		while(*s && (*s == ' ' || *s == '\t')) s++;
+
+		d2 = s + strlen(s) - 1;
+		while(d2 > s && (*d2 == ' ' || *d2 == '\t')) {
+			*d2 = 0;
+			d2--;
+		}
+
+		for (i = 0; i < 5; i++) {
+			d = strchr(s, ATTACK_LOG_DELIMITER);
 			if (!d) {
-				ERROR("Bad log string '%s' format (no time section) in the log file %s.\n", s, log_file);
-				goto error_log;
+				ERROR("Bad attack string on time %u in the log file %s.\n", time, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
 			}
 			*d = 0;
-			time = atoi(s);
-			s = d + 1;
-			while(*s && (*s == ' ' || *s == '\t')) s++;
-			if (strstr(s, LOG_POSITION) != NULL) {
-				while(*s) {
-					Object* pos_object = NULL;
-					char *d, *d2;
-					char player_pos = 0;
-					
-					while(*s && (*s == ' '  || *s == '\t')) s++;
-					d = strchr(s, POSITION_LOG_DELIMITER);
-					if (!d) {
-						d = s + strlen(s);
-					} else {
-						*d = 0;
+			/* DEBUG("token time %u i %lu '%s'\n", time, i, s); */
+			if (i == 0) {
+				size_t j;
+				for (j = 0; j < objects_count; j++) {
+					if ((objects[j].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
+						(objects[j].type != otPlayer && strcmp(objects[j].id, s) == 0)) {
+						attacker_index = j;
+						attacker = objects + j;
 					}
-
-					d2 = strchr(s, ATTACK_LOG_DELIMITER);
-					if (!d2) {
-						ERROR("Bad position string '%s' on time %u in the log file %s.\n", s, time, log_file);
-						goto error_log;
-					}
-					*d2 = 0;
-
-					if (strstr(s, LOG_PLAYER) == s) {
-						player_pos = 1;
-						for (i = 0; i < objects_count; i++) {
-							if (objects[i].type == otPlayer) {
-								pos_object = objects + i; 
-								break;
-							}
-						}
-					} else {
-						for (i = 0; i < objects_count; i++) {
-							if (objects[i].type != otPlayer && strcmp(s, objects[i].id) == 0) {
-								pos_object = objects + i;
-								break;
-							}
-						}
-					}
-					if (!pos_object) {
-						ERROR("Unknown object %s in position string on time %u in the log file %s.\n", s, time, log_file);
-						goto error_log;
-					}
-					s = d2 + 1;
-
-					pos_object->prev_pos.x = pos_object->pos.x;
-					pos_object->prev_pos.y = pos_object->pos.y;
-
-					if (!player_pos) {
-						/* skip "position:" */
-						d2 = strchr(s, ATTACK_LOG_DELIMITER);
-						if (!d2) {
-							ERROR("Bad position string '%s' on time %u in the log file %s.\n", s, time, log_file);
-							goto error_log;
-						}
-						s = d2 + 1;
-					}
-						
-					if (parse_coordinates(s, &(pos_object->pos)) != URSULA_CHECK_NO_ERROR) {
-						ERROR("Bad coordinates %s in position string on time %u in the log file %s.\n", s, time, log_file);
-						goto error_log;
-					}
-					
-					s = d + 1;
-				}
-				
-				if (!first_pos) {
-					first_pos = 1;
-				} else {
-					cyberiada_test_all_conditions(time, task, objects, objects_count, cond_matrix, NULL, objects_count, NULL, 0.0, 0);
 				}
-			} else if (strstr(s, LOG_ATTACK) == s) {
-				size_t attacker_index = 0;
-				Object *attacker = NULL, *target = NULL;
-				float damage = 0;
-				char *d2;
-
-				s += strlen(LOG_ATTACK);
-				while(*s && (*s == ' ' || *s == '\t')) s++;
-
-				d2 = s + strlen(s) - 1;
-				while(d2 > s && (*d2 == ' ' || *d2 == '\t')) {
-					*d2 = 0;
-					d2--;
+				if (!attacker) {
+					ERROR("Bad attacker id '%s' on time %u in the log file %s.\n", s, time, log_file);
+					return URSULA_CHECK_FORMAT_ERROR;
 				}
-
-				for (i = 0; i < 5; i++) {
-					d = strchr(s, ATTACK_LOG_DELIMITER);
-					if (!d) {
-						ERROR("Bad attack string on time %u in the log file %s.\n", time, log_file);
-						goto error_log;
-					}
-					*d = 0;
-					/* DEBUG("token time %u i %lu '%s'\n", time, i, s); */
-					if (i == 0) {
-						size_t j;
-						for (j = 0; j < objects_count; j++) {
-							if ((objects[j].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
-								(objects[j].type != otPlayer && strcmp(objects[j].id, s) == 0)) {
-								attacker_index = j;
-								attacker = objects + j;
-							}
-						}
-						if (!attacker) {
-							ERROR("Bad attacker id '%s' on time %u in the log file %s.\n", s, time, log_file);
-							goto error_log;
-						}
-					} else if (i == 2) {
-						damage = atof(s);
-					}
-					s = d + 1;
-				}
-				for (i= 0; i < objects_count; i++) {
-					if ((objects[i].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
-						(objects[i].type != otPlayer && strcmp(objects[i].id, s) == 0)) {
-						target = objects + i;
+			} else if (i == 2) {
+				damage = atof(s);
+			}
+			s = d + 1;
+		}
+		for (i= 0; i < objects_count; i++) {
+			if ((objects[i].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
+				(objects[i].type != otPlayer && strcmp(objects[i].id, s) == 0)) {
+				target = objects + i;
+			}
+		}
+		if (!target) {
+			ERROR("Bad target id %s on time %u in the log file %s.\n", s, time, log_file);
+			return URSULA_CHECK_FORMAT_ERROR;
+		}
+		
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVAL);
+		cyberiada_test_the_condition(condAttacked,
+									 time, task, objects, objects_count, cond_matrix, cond_frontier,
+									 attacker, attacker_index, target, damage, 0);
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVENTS);
+
+	} else if (strstr(s, LOG_ATTACKED) == s) {
+		s += strlen(LOG_ATTACKED);
+		char* d2;
+		size_t target_index = 0;
+		Object *target = NULL;
+		float damage = 0;
+
+		while(*s && (*s == ' ' || *s == '\t')) s++;
+
+		d2 = s + strlen(s) - 1;
+		while(d2 > s && (*d2 == ' ' || *d2 == '\t')) {
+			*d2 = 0;
+			d2--;
+		}
+	
+		for (i = 0; i < 4; i++) {
+			d = strchr(s, ATTACK_LOG_DELIMITER);
+			if (!d) {
+				ERROR("Bad attacked string on time %u in the log file %s.\n", time, log_file);
+				return URSULA_CHECK_FORMAT_ERROR;
+			}
+			*d = 0;
+			d2 = d - 1;
+			if (*d2 == ',') *d2 = 0;
+			/* DEBUG("token time %u i %lu '%s'\n", time, i, s); */
+			if (i == 0) {
+				size_t j;
+				for (j = 0; j < objects_count; j++) {
+					if ((objects[j].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
+						(objects[j].type != otPlayer && strcmp(objects[j].id, s) == 0)) {
+						target_index = j;
+						target = objects + j;
+						break;
 					}
 				}
 				if (!target) {
-					ERROR("Bad target id %s on time %u in the log file %s.\n", s, time, log_file);
-					goto error_log;
-				}
-				
-				cyberiada_test_the_condition(condAttacked,
-											 time, task, objects, objects_count, cond_matrix,
-											 attacker, attacker_index, target, damage, 0);
-
-			} else if (strstr(s, LOG_ATTACKED) == s) {
-				s += strlen(LOG_ATTACKED);
-				char* d2;
-				size_t target_index = 0;
-				Object *target = NULL;
-				float damage = 0;
-
-				while(*s && (*s == ' ' || *s == '\t')) s++;
-
-				d2 = s + strlen(s) - 1;
-				while(d2 > s && (*d2 == ' ' || *d2 == '\t')) {
-					*d2 = 0;
-					d2--;
-				}
-			
-				for (i = 0; i < 4; i++) {
-					d = strchr(s, ATTACK_LOG_DELIMITER);
-					if (!d) {
-						ERROR("Bad attacked string on time %u in the log file %s.\n", time, log_file);
-						goto error_log;
-					}
-					*d = 0;
-					d2 = d - 1;
-					if (*d2 == ',') *d2 = 0;
-					/* DEBUG("token time %u i %lu '%s'\n", time, i, s); */
-					if (i == 0) {
-						size_t j;
-						for (j = 0; j < objects_count; j++) {
-							if ((objects[j].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
-								(objects[j].type != otPlayer && strcmp(objects[j].id, s) == 0)) {
-								target_index = j;
-								target = objects + j;
-								break;
-							}
-						}
-						if (!target) {
-							ERROR("Bad target id '%s' on time %u in the log file %s.\n", s, time, log_file);
-							goto error_log;
-						}
-						/* DEBUG("Check damage condition for: %s id '%s'\n", s, target->id); */
-					} else if (i == 2) {
-						/* Player for 15 damage, current health: 25 (25%) */
-						damage = atof(s);
-					}
-					s = d + 1;
+					ERROR("Bad target id '%s' on time %u in the log file %s.\n", s, time, log_file);
+					return URSULA_CHECK_FORMAT_ERROR;
 				}
+				/* DEBUG("Check damage condition for: %s id '%s'\n", s, target->id); */
+			} else if (i == 2) {
+				/* Player for 15 damage, current health: 25 (25%) */
+				damage = atof(s);
+			}
+			s = d + 1;
+		}
 
-				cyberiada_test_the_condition(condDamaged,
-											 time, task, objects, objects_count, cond_matrix,
-											 target, target_index, NULL, damage, 0);
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVAL);
+		cyberiada_test_the_condition(condDamaged,
+									 time, task, objects, objects_count, cond_matrix, cond_frontier,
+									 target, target_index, NULL, damage, 0);
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVENTS);
 
-			} else if (strstr(s, LOG_DIED) != NULL) {
-				Object* died = NULL;
-				size_t died_index = 0;
-				char* d2;
+	} else if (strstr(s, LOG_DIED) != NULL) {
+		Object* died = NULL;
+		size_t died_index = 0;
+		char* d2;
 
-				s += strlen(LOG_DIED);
+		s += strlen(LOG_DIED);
 
-				while(*s && (*s == ' ' || *s == '\t')) s++;
+		while(*s && (*s == ' ' || *s == '\t')) s++;
 
-				d2 = s + strlen(s) - 1;
-				while(d2 > s && (*d2 == ' ' || *d2 == '\t')) {
-					*d2 = 0;
-					d2--;
-				}
+		d2 = s + strlen(s) - 1;
+		while(d2 > s && (*d2 == ' ' || *d2 == '\t')) {
+			*d2 = 0;
+			d2--;
+		}
+
+		for (i = 0; i < objects_count; i++) {
+			if ((objects[i].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
+				(objects[i].type != otPlayer && strcmp(objects[i].id, s) == 0)) {
+				died = objects + i;
+				died_index = i;
+			}
+		}
+		
+/*		d = strchr(s, ATTACK_LOG_DELIMITER);
+		if (!d) {
+			ERROR("Bad died string on time %u in the log file %s.\n", time, log_file);
+			return URSULA_CHECK_FORMAT_ERROR;
+		}
+		*d = 0;
+		for (i= 0; i < objects_count; i++) {
+			if ((objects[i].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
+				(objects[i].type != otPlayer && strcmp(objects[i].id, s) == 0)) {
+				died = objects + i;
+				died_index = i;
+			}
+			} */
+
+
+		
+		if (!died) {
+			ERROR("Bad died id %s on time %u in the log file %s.\n", s, time, log_file);
+			return URSULA_CHECK_FORMAT_ERROR;
+		}
+
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVAL);
+		cyberiada_test_the_condition(condDestroyed,
+									 time, task, objects, objects_count, cond_matrix, cond_frontier,
+									 died, died_index, NULL, 0.0, 0);
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVENTS);
+
+	} else if (strstr(s, LOG_GAME_OVER) == s) {
+		s += strlen(LOG_GAME_OVER);
+		if (strcmp(s, LOG_WIN) != 0) {
+			return URSULA_CHECK_NO_ERROR;
+		}
+
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVAL);
+		cyberiada_test_the_condition(condGameWon,
+									 time, task, objects, objects_count, cond_matrix, cond_frontier,
+									 NULL, objects_count, NULL, 0.0, 1);
+		stats_switch_phase(checker, meter, URSULA_CHECK_PHASE_EVENTS);
+		
+	} else if (strstr(s, LOG_SESSION_ENDED) == s) {
+		*ended = 1;
+		return URSULA_CHECK_NO_ERROR;
+	} else if (strstr(s, LOG_DIED_SKIP) != NULL) {
+		/* skip the died event, we do not need it */
+	} else {
+		ERROR("Bad log string on time %u format in the log file %s.\n", time, log_file);
+		return URSULA_CHECK_FORMAT_ERROR;				
+	}
+	return URSULA_CHECK_NO_ERROR;
+}
+
+static UrsulaCheckerTask* cyberiada_ursula_log_find_task(UrsulaLogCheckerData* checker, const char* task_name)
+{
+	UrsulaCheckerTask* task = checker->tasks;
+	while (task) {
+		if (strcmp(task->name, task_name) == 0) {
+			/* found! */
+			break;
+		}
+		task = task->next;
+	}
+	if (!task) {
+		ERROR("Cannot find task with name %s\n", task_name);
+	}
+	return task;
+}
+
+/* Check the opened log in the context of the task, the log is closed on exit */
+static int cyberiada_ursula_log_check(UrsulaLogCheckerData* checker,
+									  UrsulaCheckerTask* task,
+									  int salt,
+									  FILE* log,
+									  const char* log_file,
+									  UrsulaLogCheckerResult* result,
+									  char** result_code)
+{
+	UrsulaLogCheckerResult res = URSULA_CHECK_RESULT_ERROR;
+	Object*                objects = NULL;             /* the actual objects */
+	size_t                 objects_count = 0;          /* the actual objects count */
+	size_t                 objects_capacity = 0;
+	unsigned char**        cond_matrix = NULL;         /* the matrix of satisfied conditions (objects x conditions) */
+	unsigned char*         cond_frontier = NULL;       /* the highest satisfied condition number for each object */
+	PhaseMeter             meter = {-1, {0, 0, 0, 0, 0}}; /* the check phases statistics */
+	size_t i, line = 0;
+	char* buffer = NULL;
+	char state = 'p';
+	Point player_pos = {0.0, 0.0};
+	char first_pos = 0;
+
+	stats_switch_phase(checker, &meter, URSULA_CHECK_PHASE_SCENE);
+
+	DEBUG("Checking task:\n");
+	cyberiada_ursula_log_print_task(task);
+	
+	buffer = (char*)malloc(sizeof(char) * MAX_STR_LEN);
+
+	while(!feof(log)) {
+		line++;
+		size_t size = MAX_STR_LEN - 1;
+		ssize_t strsize = getline(&buffer, &size, log);
+		if (strsize <= 0) {
+			continue;
+		}
+
+		if (buffer[strsize - 1] == '\n') {
+			buffer[strsize - 1] = 0;
+		}
 
+		if (state == 'p' || state == 's' || state == 'o') {
+			if (scene_process_line(&state, &player_pos, &objects, &objects_count, &objects_capacity,
+								   buffer, line, log_file) != URSULA_CHECK_NO_ERROR) {
+				goto error_log;
+			}
+			if (state == 'l') {
+				DEBUG("Log objects:\n");
 				for (i = 0; i < objects_count; i++) {
-					if ((objects[i].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
-						(objects[i].type != otPlayer && strcmp(objects[i].id, s) == 0)) {
-						died = objects + i;
-						died_index = i;
-					}
-				}
-				
-/*				d = strchr(s, ATTACK_LOG_DELIMITER);
-				if (!d) {
-					ERROR("Bad died string on time %u in the log file %s.\n", time, log_file);
-					goto error_log;
+					print_object(objects + i, i + 1, "\t");
 				}
-				*d = 0;
-				for (i= 0; i < objects_count; i++) {
-					if ((objects[i].type == otPlayer && strcmp(LOG_PLAYER, s) == 0) ||
-						(objects[i].type != otPlayer && strcmp(objects[i].id, s) == 0)) {
-						died = objects + i;
-						died_index = i;
-					}
-					} */
 
-
-				
-				if (!died) {
-					ERROR("Bad died id %s on time %u in the log file %s.\n", s, time, log_file);
+				/* check objects */
+				for (i = 0; i < objects_count; i++) {
+					objects[i].class_hash = class_hash(objects[i].class);
+				}
+				if (!scene_matches_task(task, objects, objects_count, log_file)) {
 					goto error_log;
 				}
 
-				cyberiada_test_the_condition(condDestroyed,
-											 time, task, objects, objects_count, cond_matrix,
-											 died, died_index, NULL, 0.0, 0);
-
-			} else if (strstr(s, LOG_GAME_OVER) == s) {
-				s += strlen(LOG_GAME_OVER);
-				if (strcmp(s, LOG_WIN) != 0) {
-					continue;
+				cond_matrix = (unsigned char**)malloc(sizeof(unsigned char*) * MAX_CONDITIONS);
+				for (i = 0; i < MAX_CONDITIONS; i++) {
+					cond_matrix[i] = (unsigned char*)malloc(sizeof(unsigned char) * objects_count);
+					memset(cond_matrix[i], 0, sizeof(unsigned char) * objects_count);
 				}
+				cond_frontier = (unsigned char*)malloc(sizeof(unsigned char) * objects_count);
+				memset(cond_frontier, 0, sizeof(unsigned char) * objects_count);
 
-				cyberiada_test_the_condition(condGameWon,
-											 time, task, objects, objects_count, cond_matrix,
-											 NULL, objects_count, NULL, 0.0, 1);
-				
-			} else if (strstr(s, LOG_SESSION_ENDED) == s) {
+				stats_switch_phase(checker, &meter, URSULA_CHECK_PHASE_EVENTS);
+			}
+		} else if (state == 'l') {
+			char ended = 0;
+			if (cyberiada_ursula_log_process_event(checker, &meter, task, objects, objects_count,
+												   cond_matrix, cond_frontier, &first_pos,
+												   buffer, log_file, &ended) != URSULA_CHECK_NO_ERROR) {
+				goto error_log;
+			}
+			if (ended) {
 				break;
-			} else if (strstr(s, LOG_DIED_SKIP) != NULL) {
-				/* skip the died event, we do not need it */
-			} else {
-				ERROR("Bad log string on time %u format in the log file %s.\n", time, log_file);
-				goto error_log;				
 			}
 		} else {
 			ERROR("Unknown state '%c', line %lu while reading log %s\n", state, line, log_file);
@@ -1940,6 +2231,7 @@ int cyberiada_ursula_log_checker_check_log(UrsulaLogCheckerData* checker,
 		}
 		free(cond_matrix);
 	}
+	if (cond_frontier) free(cond_frontier);
 	
 	free(buffer);
 	fclose(log);
@@ -1948,14 +2240,24 @@ int cyberiada_ursula_log_checker_check_log(UrsulaLogCheckerData* checker,
 		*result = res;
 	}
 	
+	stats_switch_phase(checker, &meter, URSULA_CHECK_PHASE_HASH);
 	if (result_code) {
-		*result_code = generate_code(checker->secret, task_name, salt, res);
+		*result_code = generate_code(checker->secret, task->name, salt, res);
+	}
+	stats_switch_phase(checker, &meter, -1);
+	if (checker->stats_flags) {
+		/* the checker is shared by the concurrent checks when the stats are off */
+		checker->stats.checks++;
 	}
 	
 	return URSULA_CHECK_NO_ERROR;
 
 error_log:
 	
+	stats_switch_phase(checker, &meter, -1);
+	if (checker->stats_flags) {
+		checker->stats.failed_checks++;
+	}
 	fclose(log);
 	free(buffer);
 	if (objects) {
@@ -1972,8 +2274,468 @@ error_log:
 		}
 		free(cond_matrix);
 	}
+	if (cond_frontier) free(cond_frontier);
 	if (result) {
 		*result = URSULA_CHECK_RESULT_ERROR;
 	}
 	return URSULA_CHECK_BAD_PARAMETERS;	
 }
+
+/* Check the log file in the context of the task */
+int cyberiada_ursula_log_checker_check_log(UrsulaLogCheckerData* checker,
+										   const char* task_name,
+										   int salt,
+										   const char* log_file,
+										   UrsulaLogCheckerResult* result,
+										   char** result_code)
+{
+	UrsulaCheckerTask* task;
+	FILE* log;
+
+	if (result) {
+		*result = URSULA_CHECK_RESULT_ERROR;
+	}
+
+	if (!checker || !task_name || !log_file) {
+		ERROR("Bad check program arguments!\n");
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	task = cyberiada_ursula_log_find_task(checker, task_name);
+	if (!task) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	log = fopen(log_file, "r");
+	if (!log) {
+		ERROR("Cannot open log file %s\n", log_file);
+		return URSULA_CHECK_BAD_PARAMETERS;		
+	}
+
+	return cyberiada_ursula_log_check(checker, task, salt, log, log_file, result, result_code);
+}
+
+/* Check the log from the memory buffer in the context of the task */
+int cyberiada_ursula_log_checker_check_buffer(UrsulaLogCheckerData* checker,
+											  const char* task_name,
+											  int salt,
+											  const char* log_buffer,
+											  size_t log_buffer_size,
+											  UrsulaLogCheckerResult* result,
+											  char** result_code)
+{
+	UrsulaCheckerTask* task;
+	FILE* log;
+
+	if (result) {
+		*result = URSULA_CHECK_RESULT_ERROR;
+	}
+
+	if (!checker || !task_name || (!log_buffer && log_buffer_size)) {
+		ERROR("Bad check program arguments!\n");
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	task = cyberiada_ursula_log_find_task(checker, task_name);
+	if (!task) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	log = fmemopen((void*)(log_buffer ? log_buffer : ""), log_buffer_size, "r");
+	if (!log) {
+		ERROR("Cannot open log buffer\n");
+		return URSULA_CHECK_BAD_PARAMETERS;		
+	}
+
+	return cyberiada_ursula_log_check(checker, task, salt, log, LOG_BUFFER_NAME, result, result_code);
+}
+
+/* Enable the statistics collection */
+int cyberiada_ursula_log_checker_enable_stats(UrsulaLogCheckerData* checker, int flags)
+{
+	int res = URSULA_CHECK_NO_ERROR;
+	
+	if (!checker) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	if ((flags & URSULA_CHECK_STATS_COUNTERS) && !(checker->stats_flags & URSULA_CHECK_STATS_COUNTERS)) {
+		res = cyberiada_ursula_log_open_counters(checker);
+		if (res != URSULA_CHECK_NO_ERROR) {
+			flags &= ~URSULA_CHECK_STATS_COUNTERS;
+		}
+	} else if (!(flags & URSULA_CHECK_STATS_COUNTERS)) {
+		cyberiada_ursula_log_close_counters(checker);
+	}
+	checker->stats_flags = flags;
+
+	return res;
+}
+
+/* Get the accumulated statistics */
+int cyberiada_ursula_log_checker_get_stats(UrsulaLogCheckerData* checker, UrsulaLogCheckerStats* stats)
+{
+	if (!checker || !stats) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+	memcpy(stats, &(checker->stats), sizeof(UrsulaLogCheckerStats));
+	return URSULA_CHECK_NO_ERROR;
+}
+
+/* Reset the accumulated statistics */
+int cyberiada_ursula_log_checker_reset_stats(UrsulaLogCheckerData* checker)
+{
+	if (!checker) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+	memset(&(checker->stats), 0, sizeof(UrsulaLogCheckerStats));
+	return URSULA_CHECK_NO_ERROR;
+}
+
+/* Detect the tasks whose scene constraints can match the scene table of the log */
+int cyberiada_ursula_log_checker_detect_tasks(UrsulaLogCheckerData* checker,
+											  const char* log_file,
+											  const char*** task_ids,
+											  size_t* tasks_count)
+{
+	UrsulaCheckerTask*     task;
+	Object*                objects = NULL;             /* the scene objects */
+	size_t                 objects_count = 0;          /* the scene objects count */
+	size_t                 objects_capacity = 0;
+	unsigned int           scene_types = 0;            /* the scene fingerprint: the mask of the object types */
+	const char**           found_tasks = NULL;
+	size_t                 found_count = 0;
+	size_t i, line = 0;
+	char* buffer = NULL;
+	FILE* log = NULL;
+	char state = 'p';
+	Point player_pos = {0.0, 0.0};
+	int res = URSULA_CHECK_NO_ERROR;
+
+	if (!checker || !log_file || !task_ids || !tasks_count) {
+		ERROR("Bad detect tasks arguments!\n");
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	*task_ids = NULL;
+	*tasks_count = 0;
+
+	log = fopen(log_file, "r");
+	if (!log) {
+		ERROR("Cannot open log file %s\n", log_file);
+		return URSULA_CHECK_BAD_PARAMETERS;		
+	}
+
+	buffer = (char*)malloc(sizeof(char) * MAX_STR_LEN);
+
+	/* read the scene table only */
+	
+	while(state != 'l' && !feof(log)) {
+		line++;
+		size_t size = MAX_STR_LEN - 1;
+		ssize_t strsize = getline(&buffer, &size, log);
+		if (strsize <= 0) {
+			continue;
+		}
+
+		if (buffer[strsize - 1] == '\n') {
+			buffer[strsize - 1] = 0;
+		}
+
+		res = scene_process_line(&state, &player_pos, &objects, &objects_count, &objects_capacity,
+								 buffer, line, log_file);
+		if (res != URSULA_CHECK_NO_ERROR) {
+			break;
+		}
+	}
+
+	if (res == URSULA_CHECK_NO_ERROR && state != 'l') {
+		ERROR("Cannot find the scene objects table in the log file %s.\n", log_file);
+		res = URSULA_CHECK_FORMAT_ERROR;
+	}
+
+	if (res == URSULA_CHECK_NO_ERROR) {
+		/* the scene fingerprint */
+		for (i = 0; i < objects_count; i++) {
+			objects[i].class_hash = class_hash(objects[i].class);
+			scene_types |= 1 << objects[i].type;
+		}
+
+		found_tasks = (const char**)malloc(sizeof(const char*) * (TASKS_CHUNK + 1));
+		for (task = checker->tasks; task; task = task->next) {
+			char match = (task->scene_types & ~scene_types) == 0 &&
+				scene_matches_task(task, objects, objects_count, NULL);
+
+			if (match) {
+				if (found_count > 0 && found_count % TASKS_CHUNK == 0) {
+					found_tasks = (const char**)realloc(found_tasks,
+														sizeof(const char*) * (found_count + TASKS_CHUNK + 1));
+				}
+				DEBUG("Scene matches task %s\n", task->name);
+				found_tasks[found_count++] = task->name;
+			}
+		}
+		found_tasks[found_count] = NULL;
+
+		*task_ids = found_tasks;
+		*tasks_count = found_count;
+	}
+
+	if (objects) {
+		for (i = 0; i < objects_count; i++) {
+			Object* obj = objects + i;
+			if (obj->class) free(obj->class);
+			if (obj->id) free(obj->id);
+		}
+		free(objects);
+	}
+
+	free(buffer);
+	fclose(log);
+
+	return res;
+}
+
+/* -----------------------------------------------------------------------------
+ * The live log session functions
+ * ----------------------------------------------------------------------------- */
+
+
+/* Create the session checking the log of the task incrementally */
+int cyberiada_ursula_log_session_new(UrsulaLogCheckerData* checker,
+									 const char* task_name,
+									 UrsulaLogSession** session)
+{
+	UrsulaCheckerTask* task;
+
+	if (!checker || !task_name || !session) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	task = cyberiada_ursula_log_find_task(checker, task_name);
+	if (!task) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	*session = (UrsulaLogSession*)malloc(sizeof(UrsulaLogSession));
+	memset(*session, 0, sizeof(UrsulaLogSession));
+	(*session)->checker = checker;
+	(*session)->task = task;
+	(*session)->state = 'p';
+
+	return URSULA_CHECK_NO_ERROR;
+}
+
+static int cyberiada_ursula_log_session_start_events(UrsulaLogSession* session)
+{
+	UrsulaCheckerTask* task = session->task;
+	size_t i, rows_size;
+
+	for (i = 0; i < session->objects_count; i++) {
+		session->objects[i].class_hash = class_hash(session->objects[i].class);
+	}
+	if (!scene_matches_task(task, session->objects, session->objects_count, SESSION_LOG_NAME)) {
+		return URSULA_CHECK_FORMAT_ERROR;
+	}
+
+	/* the row pointers, the rows and the frontier in one block */
+	rows_size = sizeof(unsigned char*) * task->conditions_count;
+	session->cond_matrix_size = rows_size + (task->conditions_count + 1) * session->objects_count;
+	session->cond_matrix = (unsigned char**)malloc(session->cond_matrix_size);
+	memset(session->cond_matrix, 0, session->cond_matrix_size);
+	for (i = 0; i < task->conditions_count; i++) {
+		session->cond_matrix[i] = (unsigned char*)session->cond_matrix + rows_size + i * session->objects_count;
+	}
+	session->cond_frontier = (unsigned char*)session->cond_matrix + rows_size +
+		task->conditions_count * session->objects_count;
+
+	return URSULA_CHECK_NO_ERROR;
+}
+
+static int cyberiada_ursula_log_session_line(UrsulaLogSession* session)
+{
+	int res = URSULA_CHECK_NO_ERROR;
+
+	session->lines++;
+
+	if (session->state == 'p' || session->state == 's' || session->state == 'o') {
+		res = scene_process_line(&(session->state), &(session->player_pos),
+								 &(session->objects), &(session->objects_count), &(session->objects_capacity),
+								 session->line, session->lines, SESSION_LOG_NAME);
+		if (res == URSULA_CHECK_NO_ERROR && session->state == 'l') {
+			res = cyberiada_ursula_log_session_start_events(session);
+		}
+	} else if (session->state == 'l') {
+		char ended = 0;
+		res = cyberiada_ursula_log_process_event(NULL, NULL, session->task,
+												 session->objects, session->objects_count,
+												 session->cond_matrix, session->cond_frontier, &(session->first_pos),
+												 session->line, SESSION_LOG_NAME, &ended);
+		if (res == URSULA_CHECK_NO_ERROR && ended) {
+			session->state = 'e';
+		}
+	}
+
+	if (res != URSULA_CHECK_NO_ERROR) {
+		session->state = 'x';
+	}
+	return res;
+}
+
+/* Feed the next part of the log to the session */
+int cyberiada_ursula_log_session_feed(UrsulaLogSession* session, const char* data, size_t size)
+{
+	if (!session || (!data && size)) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	while (size > 0) {
+		const char* eol;
+		size_t chunk;
+
+		if (session->state == 'e') {
+			return URSULA_CHECK_NO_ERROR; /* skip the data after the session end */
+		}
+		if (session->state == 'x') {
+			return URSULA_CHECK_FORMAT_ERROR;
+		}
+
+		eol = (const char*)memchr(data, '\n', size);
+		chunk = eol ? (size_t)(eol - data) : size;
+
+		if (session->line_size + chunk + 1 > session->line_capacity) {
+			size_t capacity = session->line_size + chunk + 1;
+			if (capacity > MAX_SESSION_LINE_LEN) {
+				ERROR("Too long line %lu in the log session\n", session->lines + 1);
+				session->state = 'x';
+				return URSULA_CHECK_FORMAT_ERROR;
+			}
+			capacity = (capacity + SESSION_LINE_CHUNK - 1) / SESSION_LINE_CHUNK * SESSION_LINE_CHUNK;
+			session->line = (char*)realloc(session->line, capacity);
+			session->line_capacity = capacity;
+		}
+		memcpy(session->line + session->line_size, data, chunk);
+		session->line_size += chunk;
+
+		if (!eol) {
+			break;
+		}
+
+		session->line[session->line_size] = 0;
+		cyberiada_ursula_log_session_line(session);
+		session->line_size = 0;
+		data = eol + 1;
+		size -= chunk + 1;
+	}
+
+	return session->state == 'x' ? URSULA_CHECK_FORMAT_ERROR : URSULA_CHECK_NO_ERROR;
+}
+
+/* Finish the session log: process the last line without the line end */
+int cyberiada_ursula_log_session_finish(UrsulaLogSession* session)
+{
+	if (!session) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	if (session->line_size > 0 && session->state != 'e' && session->state != 'x') {
+		session->line[session->line_size] = 0;
+		cyberiada_ursula_log_session_line(session);
+		session->line_size = 0;
+	}
+
+	return session->state == 'x' ? URSULA_CHECK_FORMAT_ERROR : URSULA_CHECK_NO_ERROR;
+}
+
+/* Get the session state */
+int cyberiada_ursula_log_session_state(UrsulaLogSession* session)
+{
+	if (!session) {
+		return URSULA_SESSION_ERROR;
+	}
+	switch (session->state) {
+	case 'l': return URSULA_SESSION_EVENTS;
+	case 'e': return URSULA_SESSION_ENDED;
+	case 'x': return URSULA_SESSION_ERROR;
+	default: return URSULA_SESSION_SCENE;
+	}
+}
+
+/* Get the current session result and the encoded result string */
+int cyberiada_ursula_log_session_result(UrsulaLogSession* session,
+										int salt,
+										UrsulaLogCheckerResult* result,
+										char** result_code)
+{
+	UrsulaLogCheckerResult res = URSULA_CHECK_RESULT_ERROR;
+	size_t i, j;
+
+	if (!session || session->state == 'x') {
+		if (result) {
+			*result = URSULA_CHECK_RESULT_ERROR;
+		}
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	if (session->cond_matrix) {
+		for (i = 0; i < session->task->conditions_count; i++) {
+			for (j = 0; j < session->objects_count; j++) {
+				if (session->cond_matrix[i][j]) {
+					res |= (1 << i);
+					break;
+				}
+			}
+		}
+	}
+
+	if (result) {
+		*result = res;
+	}
+	if (result_code) {
+		*result_code = generate_code(session->checker->secret, session->task->name, salt, res);
+	}
+
+	return URSULA_CHECK_NO_ERROR;
+}
+
+/* Get the memory allocated by the session */
+size_t cyberiada_ursula_log_session_memory(UrsulaLogSession* session)
+{
+	size_t i, size;
+
+	if (!session) {
+		return 0;
+	}
+
+	size = sizeof(UrsulaLogSession) + session->line_capacity + session->cond_matrix_size +
+		sizeof(Object) * session->objects_capacity;
+	for (i = 0; i < session->objects_count; i++) {
+		if (session->objects[i].class) size += strlen(session->objects[i].class) + 1;
+		if (session->objects[i].id) size += strlen(session->objects[i].id) + 1;
+	}
+	return size;
+}
+
+/* Free the session */
+int cyberiada_ursula_log_session_free(UrsulaLogSession* session)
+{
+	size_t i;
+
+	if (!session) {
+		return URSULA_CHECK_BAD_PARAMETERS;
+	}
+
+	if (session->objects) {
+		for (i = 0; i < session->objects_count; i++) {
+			Object* obj = session->objects + i;
+			if (obj->class) free(obj->class);
+			if (obj->id) free(obj->id);
+		}
+		free(session->objects);
+	}
+	if (session->cond_matrix) free(session->cond_matrix);
+	if (session->line) free(session->line);
+	free(session);
+
+	return URSULA_CHECK_NO_ERROR;
+}
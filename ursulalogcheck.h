@@ -23,6 +23,8 @@
 #ifndef __URSULA_LOG_CHECK_H
 #define __URSULA_LOG_CHECK_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,6 +36,10 @@ extern "C" {
 struct _UrsulaLogCheckerData;
 typedef struct _UrsulaLogCheckerData UrsulaLogCheckerData;
 
+/* The live log session (the incremental log checking) */
+struct _UrsulaLogSession;
+typedef struct _UrsulaLogSession UrsulaLogSession;
+
 /* -----------------------------------------------------------------------------
  * The library checker result codes
  * ----------------------------------------------------------------------------- */
@@ -50,6 +56,47 @@ typedef char UrsulaLogCheckerResult;
 #define URSULA_CHECK_NO_ERROR       0
 #define URSULA_CHECK_BAD_PARAMETERS 1
 #define URSULA_CHECK_FORMAT_ERROR   2
+#define URSULA_CHECK_NOT_SUPPORTED  3
+
+/* -----------------------------------------------------------------------------
+ * The live log session states
+ * ----------------------------------------------------------------------------- */
+
+#define URSULA_SESSION_SCENE        0	/* reading the log header and the scene table */
+#define URSULA_SESSION_EVENTS       1	/* reading the log events */
+#define URSULA_SESSION_ENDED        2	/* the game session ended */
+#define URSULA_SESSION_ERROR        3	/* the log format error */
+
+/* -----------------------------------------------------------------------------
+ * The checker statistics
+ * ----------------------------------------------------------------------------- */
+
+/* The phases of the log checking */
+#define URSULA_CHECK_PHASE_SCENE    0	/* the scene table parsing */
+#define URSULA_CHECK_PHASE_EVENTS   1	/* the log events parsing */
+#define URSULA_CHECK_PHASE_EVAL     2	/* the conditions evaluation */
+#define URSULA_CHECK_PHASE_HASH     3	/* the result code hashing */
+#define URSULA_CHECK_PHASES_COUNT   4
+
+/* The statistics collection flags */
+#define URSULA_CHECK_STATS_NONE     0
+#define URSULA_CHECK_STATS_TIME     1	/* the wall clock time of the phases */
+#define URSULA_CHECK_STATS_COUNTERS 2	/* the hardware performance counters (Linux perf events) */
+
+typedef struct {
+	unsigned long long time_ns;                 /* the wall clock time in nanoseconds */
+	unsigned long long cycles;                  /* the CPU cycles */
+	unsigned long long instructions;            /* the retired instructions */
+	unsigned long long cache_misses;            /* the last level cache misses */
+	unsigned long long branch_misses;           /* the mispredicted branches */
+} UrsulaLogCheckerPhaseStats;
+
+typedef struct {
+	unsigned long long         checks;          /* the number of the checked logs */
+	unsigned long long         failed_checks;   /* the number of the logs failed to check (their
+	                                               phases time is in the stats too) */
+	UrsulaLogCheckerPhaseStats phases[URSULA_CHECK_PHASES_COUNT];
+} UrsulaLogCheckerStats;
 
 /* -----------------------------------------------------------------------------
  * The checker library functions
@@ -71,6 +118,70 @@ typedef char UrsulaLogCheckerResult;
 											   UrsulaLogCheckerResult* result,
 											   char** result_code);
 
+	/* Check the log from the memory buffer in the context of the task.
+       Returns the actual result and the encoded result string */
+	int cyberiada_ursula_log_checker_check_buffer(UrsulaLogCheckerData* checker,
+												  const char* task_id,
+												  int salt,
+												  const char* log_buffer,
+												  size_t log_buffer_size,
+												  UrsulaLogCheckerResult* result,
+												  char** result_code);
+
+	/* Detect the tasks whose scene constraints (base objects and object requirements)
+	   can match the scene table of the log file. Only the scene table is read.
+	   Returns the NULL-terminated array of the task identifiers in task_ids (the array
+	   should be freed by the caller, the identifiers belong to the checker) */
+	int cyberiada_ursula_log_checker_detect_tasks(UrsulaLogCheckerData* checker,
+												  const char* log_file,
+												  const char*** task_ids,
+												  size_t* tasks_count);
+
+	/* Enable the statistics collection (URSULA_CHECK_STATS_* flags). The hardware
+	   counters are opened for the calling thread only, the function returns
+	   URSULA_CHECK_NOT_SUPPORTED if they are not available. The checks are counted
+	   only while the statistics are enabled */
+	int cyberiada_ursula_log_checker_enable_stats(UrsulaLogCheckerData* checker, int flags);
+
+	/* Get the statistics accumulated since the last reset */
+	int cyberiada_ursula_log_checker_get_stats(UrsulaLogCheckerData* checker, UrsulaLogCheckerStats* stats);
+
+	/* Reset the accumulated statistics */
+	int cyberiada_ursula_log_checker_reset_stats(UrsulaLogCheckerData* checker);
+
+/* -----------------------------------------------------------------------------
+ * The live log session functions
+ * ----------------------------------------------------------------------------- */
+
+	/* Create the session checking the log of the task incrementally. The sessions
+	   share the task plan of the checker, so the checker should not be freed
+	   before the sessions */
+	int cyberiada_ursula_log_session_new(UrsulaLogCheckerData* checker,
+										 const char* task_id,
+										 UrsulaLogSession** session);
+
+	/* Feed the next part of the log (not necessarily the complete lines) */
+	int cyberiada_ursula_log_session_feed(UrsulaLogSession* session, const char* data, size_t size);
+
+	/* Finish the session when the log is over: the last line without the line end
+	   is processed as check_log does it. Call it before getting the final result */
+	int cyberiada_ursula_log_session_finish(UrsulaLogSession* session);
+
+	/* Get the session state (URSULA_SESSION_*) */
+	int cyberiada_ursula_log_session_state(UrsulaLogSession* session);
+
+	/* Get the result of the log part read so far and the encoded result string */
+	int cyberiada_ursula_log_session_result(UrsulaLogSession* session,
+											int salt,
+											UrsulaLogCheckerResult* result,
+											char** result_code);
+
+	/* Get the memory allocated by the session in bytes */
+	size_t cyberiada_ursula_log_session_memory(UrsulaLogSession* session);
+
+	/* Free the session */
+	int cyberiada_ursula_log_session_free(UrsulaLogSession* session);
+
 #ifdef __cplusplus
 }
 #endif